@@ -0,0 +1,84 @@
+#include "barcache.h"
+
+void BarCache::aggregate(XYStorage *storage, const BarLevel &level, size_t from, size_t to, vector<XYBucket> &out) const {
+    qint64 key = out.empty() ? 0 : level.keyOf(out.back().min_x);
+    for(size_t i = from; i < to; i++) {
+        XYItem item = storage->at(i);
+        qint64 k = level.keyOf(item.x());
+        if(out.empty() || k != key) {
+            XYBucket bucket;
+            bucket.reset(item);
+            out.push_back(bucket);
+            key = k;
+        } else {
+            out.back().extend(item);
+        }
+    }
+}
+
+const BarLevel& BarCache::get(XYSeries *series, int level, qreal min_x, qreal max_x) {
+    XYStorage *storage = series->getStorage();
+    qreal step = ldexp(1.0, level);
+    size_t lo = series->lowerBound(floor(min_x / step) * step);
+    size_t hi = series->lowerBound((floor(max_x / step) + 1) * step);
+
+    auto found = levels.find(level);
+    if(found == levels.end() && levels.size() >= LEVELS_MAX) {
+        auto oldest = min_element(used.begin(), used.end(), [](const pair<const int, quint64> &a, const pair<const int, quint64> &b) {
+            return a.second < b.second;
+        });
+        levels.erase(oldest->first);
+        used.erase(oldest);
+    }
+    used[level] = ++uses;
+    BarLevel &bars = levels[level];
+    if(found == levels.end() || hi < bars.first || lo > bars.last || bars.buckets.size() > BUCKETS_MAX) {
+        bars.step = step;
+        bars.buckets.clear();
+        bars.first = bars.last = lo;
+    }
+    // Range ends other than the series end fall on bucket boundaries, but
+    // the ticks before the cached range may still share its first bucket.
+    if(lo < bars.first) {
+        vector<XYBucket> head;
+        aggregate(storage, bars, lo, bars.first, head);
+        if(!head.empty() && !bars.buckets.empty() && bars.keyOf(head.back().min_x) == bars.keyOf(bars.buckets.front().min_x)) {
+            XYBucket &front = bars.buckets.front();
+            const XYBucket &back = head.back();
+            front.min_x = back.min_x;
+            front.first_y = back.first_y;
+            front.min_y = min(front.min_y, back.min_y);
+            front.max_y = max(front.max_y, back.max_y);
+            head.pop_back();
+        }
+        bars.buckets.insert(bars.buckets.begin(), head.begin(), head.end());
+        bars.first = lo;
+    }
+    if(hi > bars.last) {
+        aggregate(storage, bars, bars.last, hi, bars.buckets);
+        bars.last = hi;
+    }
+    return bars;
+}
+
+void BarCache::onAppended(size_t index) {
+    for(auto it = levels.begin(); it != levels.end();) {
+        if(index < it->second.last) {
+            used.erase(it->first);
+            it = levels.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void BarCache::onChanged(size_t count) {
+    for(auto it = levels.begin(); it != levels.end();) {
+        if(count < it->second.last) {
+            used.erase(it->first);
+            it = levels.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
@@ -0,0 +1,57 @@
+#ifndef BARCACHE_H
+#define BARCACHE_H
+
+#include <map>
+
+#include "series.h"
+
+// Open/high/low/close of a sorted series per time bucket of one level: the
+// buckets of level l are step = 2^l wide and start at multiples of step,
+// so they don't depend on where the view is. Only non-empty buckets are
+// kept (first_y open, max_y high, min_y low, last_y close), for the
+// contiguous sample range [first, last).
+class BarLevel {
+public:
+    qreal step;
+    size_t first;
+    size_t last;
+    vector<XYBucket> buckets;
+
+public:
+    BarLevel() : step(1), first(0), last(0) {}
+    qint64 keyOf(qreal x) const {
+        return (qint64)floor(x / step);
+    }
+};
+
+// Per level bucket cache for candlestick and band drawing, so the cost of
+// a frame follows the bucket count rather than the tick count. A level
+// only covers the samples a view asked for; panning and appends aggregate
+// just the samples newly in range, and zooming back finds its level still
+// there. Ticks appended before the aggregated range end (late samples, a
+// ring storage turning over) drop the levels they touch.
+class BarCache {
+public:
+    constexpr static size_t LEVELS_MAX = 8;
+    constexpr static size_t BUCKETS_MAX = 1 << 18;
+
+private:
+    map<int, BarLevel> levels;
+    map<int, quint64> used;
+    quint64 uses;
+
+    void aggregate(XYStorage *storage, const BarLevel &level, size_t from, size_t to, vector<XYBucket> &out) const;
+
+public:
+    BarCache() : uses(0) {}
+    // The finest level whose buckets are at least step wide.
+    static int levelFor(qreal step) {
+        return (int)ceil(log2(step));
+    }
+    // Buckets of level covering at least [min_x, max_x] of series.
+    const BarLevel& get(XYSeries *series, int level, qreal min_x, qreal max_x);
+    void onAppended(size_t index);
+    void onChanged(size_t count);
+};
+
+#endif // BARCACHE_H
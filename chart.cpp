@@ -1,9 +1,49 @@
 #include "chart.h"
 
+namespace {
+
+// pos() is deprecated from Qt 5.14 on for wheel events and Qt 6 for mouse
+// events, in favour of position().
+QPoint eventPos(QMouseEvent *event) {
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    return event->position().toPoint();
+#else
+    return event->pos();
+#endif
+}
+
+QPoint eventPos(QWheelEvent *event) {
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+    return event->position().toPoint();
+#else
+    return event->pos();
+#endif
+}
+
+QPoint eventGlobalPos(QMouseEvent *event) {
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    return event->globalPosition().toPoint();
+#else
+    return event->globalPos();
+#endif
+}
+
+}
+
 Chart::Chart(QWidget *parent) :
-    QWidget(parent)
+    QWidget(parent),
+    render(nullptr),
+    frame_valid(false),
+    paints(0)
 {
-
+    connect(&sync_timer, SIGNAL(timeout()), this, SLOT(onSyncTimer()));
+    idle_timer.setSingleShot(true);
+    progress_timer.setSingleShot(true);
+    connect(&progress_timer, SIGNAL(timeout()), this, SLOT(onProgressTimer()));
+    connect(&stats_timer, SIGNAL(timeout()), this, SLOT(onStatsTimer()));
+    connect(&idle_timer, SIGNAL(timeout()), this, SLOT(onIdleTimer()));
+    setMouseTracking(true);
+    setAttribute(Qt::WA_OpaquePaintEvent);
 }
 
 Chart::~Chart()
@@ -21,15 +61,77 @@ void Chart::setRender(XYRender* render) {
 XYRender* Chart::getRender() const {
     return render;
 }
-void Chart::onRenderChanged(const RenderChangeEvent*) {
-    this->repaint();
+// Polls the series for samples appended from outside (e.g. a shared-memory
+// producer); 0 stops polling.
+void Chart::setSyncInterval(int msec) {
+    if(msec > 0) {
+        sync_timer.start(msec);
+    } else {
+        sync_timer.stop();
+    }
+}
+// Render statistics with this view's paint count.
+RenderStats Chart::getStats() const {
+    RenderStats stats = render ? render->getStats() : RenderStats();
+    stats.paints = paints;
+    return stats;
+}
+// Logs getStats() every msec; 0 stops logging.
+void Chart::setStatsInterval(int msec) {
+    if(msec > 0) {
+        stats_timer.start(msec);
+    } else {
+        stats_timer.stop();
+    }
+}
+void Chart::onStatsTimer() {
+    qDebug().noquote() << "stats:" << getStats().toString();
+}
+void Chart::onSyncTimer() {
+    if(render) render->sync();
+}
+void Chart::onIdleTimer() {
+    if(render) render->refine();
+}
+// Lets the event loop run before painting the next slice of an incomplete
+// progressive frame.
+void Chart::onProgressTimer() {
+    frame_valid = false;
+    update();
+}
+// Overlay changes only repaint their rects over the cached frame.
+void Chart::onRenderChanged(const RenderChangeEvent* event) {
+    if(event->overlay) {
+        for(const QRect &rect : event->rects) {
+            this->update(rect);
+        }
+        return;
+    }
+    frame_valid = false;
+    this->update();
 }
 
-void Chart::paintEvent(QPaintEvent *) {
-    if(render) {
-        QPainter painter(this);
-        render->paint(&painter, this);
+void Chart::paintEvent(QPaintEvent *event) {
+    if(!render) return;
+    paints++;
+    qreal ratio = devicePixelRatioF();
+    if(!frame_valid || frame.size() != size() * ratio) {
+        frame = QPixmap(size() * ratio);
+        frame.setDevicePixelRatio(ratio);
+        QPainter painter(&frame);
+        render->paintContent(&painter, this, true);
+        frame_valid = true;
+        if(render->isDraft()) idle_timer.start(render->getIdleDelay());
+        if(!render->isComplete()) progress_timer.start(0);
+    }
+    // Separate overlay updates arrive as one region whose bounding rect may
+    // cover the whole plot, so only its own rects are blitted.
+    QPainter painter(this);
+    painter.setClipRegion(event->region());
+    for(const QRect &rect : event->region()) {
+        painter.drawPixmap(QRectF(rect), frame, QRectF(rect.x() * ratio, rect.y() * ratio, rect.width() * ratio, rect.height() * ratio));
     }
+    render->paintOverlay(&painter);
 }
 
 void Chart::mousePressEvent(QMouseEvent *event) {
@@ -39,14 +141,44 @@ void Chart::mousePressEvent(QMouseEvent *event) {
     } else {
         btn = event->button();
     }
+    render->hideCrosshair();
+    if(btn == Qt::RightButton) {
+        render->zoomBack();
+        return;
+    }
 
-    render->startGesture(btn, event->pos());
+    render->startGesture(btn, eventPos(event));
 }
 void Chart::mouseReleaseEvent(QMouseEvent *event) {
-    render->endGesture(event->pos());
+    render->endGesture(eventPos(event));
 }
 
 void Chart::mouseMoveEvent(QMouseEvent *event) {
-    render->updateGesture(event->pos());
+    if(event->buttons() == Qt::NoButton) {
+        showPick(event);
+        return;
+    }
+    render->updateGesture(eventPos(event));
+}
+// Tooltip with the sample nearest to the cursor.
+void Chart::showPick(QMouseEvent *event) {
+    if(!render) return;
+    render->moveCrosshair(eventPos(event));
+    PickResult result;
+    if(render->pick(eventPos(event), result)) {
+        QString text = QString("%1\nx: %2\ny: %3").arg(result.series->getName()).arg(result.item.x()).arg(result.item.y());
+        QToolTip::showText(eventGlobalPos(event), text, this);
+    } else {
+        QToolTip::hideText();
+    }
+}
+
+// One wheel notch zooms by 20% around the cursor.
+void Chart::wheelEvent(QWheelEvent *event) {
+    if(!render || event->angleDelta().y() == 0) return;
+    render->zoomAt(eventPos(event), pow(0.8, event->angleDelta().y() / 120.0));
 }
 
+void Chart::leaveEvent(QEvent *) {
+    if(render) render->hideCrosshair();
+}
@@ -6,12 +6,17 @@
 #include <QPainter>
 #include <QFontMetrics>
 #include <QMouseEvent>
+#include <QWheelEvent>
+#include <QTimer>
+#include <QToolTip>
+#include <QPixmap>
 
 #include "type.h"
 #include "axis.h"
 #include "series.h"
 #include "range.h"
 #include "render.h"
+#include "renderstats.h"
 
 
 using namespace std;
@@ -27,15 +32,33 @@ public:
 
     void setRender(XYRender* render);
     XYRender* getRender() const;
+    void setSyncInterval(int msec);
+    RenderStats getStats() const;
+    void setStatsInterval(int msec);
     void onRenderChanged(const RenderChangeEvent* event);
     void mousePressEvent(QMouseEvent *event) override;
     void mouseReleaseEvent(QMouseEvent *event) override;
     void mouseMoveEvent(QMouseEvent *event) override;
+    void wheelEvent(QWheelEvent *event) override;
+    void leaveEvent(QEvent *event) override;
 
 protected:
     void paintEvent(QPaintEvent *event) override;
 private:
     XYRender* render;
+    QTimer sync_timer;
+    QTimer idle_timer;
+    QTimer progress_timer;
+    QTimer stats_timer;
+    QPixmap frame;
+    bool frame_valid;
+    quint64 paints;
+    void showPick(QMouseEvent *event);
+private slots:
+    void onSyncTimer();
+    void onIdleTimer();
+    void onProgressTimer();
+    void onStatsTimer();
 };
 
 #endif // CHART_H
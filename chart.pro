@@ -4,10 +4,6 @@
 #
 #-------------------------------------------------
 
-QT       += core gui
-
-greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
-
 TARGET = chart
 TEMPLATE = app
 
@@ -23,22 +19,13 @@ DEFINES += QT_DEPRECATED_WARNINGS
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 
+include(core.pri)
+
 SOURCES += \
         main.cpp \
-        chart.cpp \
-    axis.cpp \
-    range.cpp \
-    series.cpp \
-    render.cpp \
     mainwindow.cpp
 
 HEADERS += \
-        chart.h \
-    axis.h \
-    range.h \
-    type.h \
-    series.h \
-    render.h \
     mainwindow.h
 
 FORMS += \
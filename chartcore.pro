@@ -0,0 +1,14 @@
+#-------------------------------------------------
+#
+# The chart engine as a static library, for tools and benchmarks that
+# link it instead of compiling core.pri into themselves.
+#
+#-------------------------------------------------
+
+TARGET = chartcore
+TEMPLATE = lib
+CONFIG += staticlib
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+include(core.pri)
@@ -0,0 +1,283 @@
+#include "compressedstorage.h"
+
+#include <atomic>
+#include <cstring>
+
+namespace {
+
+inline uint64_t bitsOf(qreal v) {
+    uint64_t b;
+    memcpy(&b, &v, sizeof(b));
+    return b;
+}
+
+inline qreal valueOf(uint64_t b) {
+    qreal v;
+    memcpy(&v, &b, sizeof(v));
+    return v;
+}
+
+// MSB-first bit packing into 64-bit words.
+class BitWriter {
+private:
+    vector<uint64_t> &out;
+    int used;
+
+public:
+    BitWriter(vector<uint64_t> &_out) : out(_out), used(64) {}
+    void write(uint64_t value, int n) {
+        if(n == 0) return;
+        if(n < 64) value &= (uint64_t(1) << n) - 1;
+        if(used == 64) {
+            out.push_back(0);
+            used = 0;
+        }
+        int space = 64 - used;
+        if(n <= space) {
+            out.back() |= value << (space - n);
+            used += n;
+        } else {
+            int rest = n - space;
+            out.back() |= value >> rest;
+            out.push_back(value << (64 - rest));
+            used = rest;
+        }
+    }
+};
+
+class BitReader {
+private:
+    const uint64_t *in;
+    int pos;
+
+public:
+    BitReader(const uint64_t *_in) : in(_in), pos(0) {}
+    uint64_t read(int n) {
+        if(n == 0) return 0;
+        int space = 64 - pos;
+        if(n <= space) {
+            uint64_t v = (*in << pos) >> (64 - n);
+            pos += n;
+            if(pos == 64) {
+                pos = 0;
+                in++;
+            }
+            return v;
+        }
+        int rest = n - space;
+        uint64_t high = (*in << pos) >> pos;
+        in++;
+        pos = rest;
+        return (high << rest) | (*in >> (64 - rest));
+    }
+    bool bit() {
+        return read(1);
+    }
+};
+
+// Zigzag-coded delta-of-delta in 1, 2+6, 3+13, 4+20 or 4+64 bits. The
+// deltas are taken modulo 2^64, so any jump between bit patterns
+// round-trips.
+inline void writeDelta(BitWriter &w, uint64_t dod) {
+    uint64_t z = (dod << 1) ^ (0 - (dod >> 63));
+    if(z == 0) {
+        w.write(0, 1);
+    } else if(z < (uint64_t(1) << 6)) {
+        w.write(2, 2);
+        w.write(z, 6);
+    } else if(z < (uint64_t(1) << 13)) {
+        w.write(6, 3);
+        w.write(z, 13);
+    } else if(z < (uint64_t(1) << 20)) {
+        w.write(14, 4);
+        w.write(z, 20);
+    } else {
+        w.write(15, 4);
+        w.write(z, 64);
+    }
+}
+
+inline uint64_t readDelta(BitReader &r) {
+    uint64_t z;
+    if(!r.bit()) return 0;
+    if(!r.bit()) z = r.read(6);
+    else if(!r.bit()) z = r.read(13);
+    else if(!r.bit()) z = r.read(20);
+    else z = r.read(64);
+    return (z >> 1) ^ (0 - (z & 1));
+}
+
+std::atomic<uint64_t> next_id(1);
+
+// The last blocks decoded on this thread, so concurrent readers each keep
+// their own and a sequential scan still decodes every block once.
+class DecodeCache {
+public:
+    constexpr static int SIZE = 4;
+
+    uint64_t ids[SIZE];
+    size_t blocks[SIZE];
+    vector<XYItem> items[SIZE];
+    int next;
+
+public:
+    DecodeCache() : next(0) {
+        for(int i = 0; i < SIZE; i++) ids[i] = 0;
+    }
+};
+
+thread_local DecodeCache decode_cache;
+
+}
+
+CompressedStorage::CompressedStorage() : id(next_id++) {
+    tail.reserve(2 * BLOCK);
+}
+
+void CompressedStorage::append(const XYItem &item) {
+    extendTail(item);
+    if(tail.size() == 2 * BLOCK) seal();
+}
+
+void CompressedStorage::extendTail(const XYItem &item) {
+    size_t i = tail.size();
+    XYBucket &bounds = tail_bounds[i / BLOCK];
+    if(i % BLOCK == 0) bounds.reset(item);
+    else bounds.extend(item);
+    tail.push_back(item);
+}
+
+void CompressedStorage::insert(size_t index, const XYItem *items, size_t count) {
+    size_t sealed = blocks.size() * BLOCK;
+    if(index < sealed) throw 1;
+    vector<XYItem> rest(tail.begin() + (index - sealed), tail.end());
+    vector<XYItem> head(tail.begin(), tail.begin() + (index - sealed));
+    tail.clear();
+    for(const XYItem &item : head) extendTail(item);
+    size_t i = 0;
+    size_t j = 0;
+    while(i < rest.size() || j < count) {
+        if(j == count || (i < rest.size() && rest[i] < items[j])) append(rest[i++]);
+        else append(items[j++]);
+    }
+}
+
+void CompressedStorage::clear() {
+    blocks.clear();
+    tail.clear();
+    tail.reserve(2 * BLOCK);
+    id = next_id++;
+}
+
+// Compresses the tail's first BLOCK samples into a block.
+void CompressedStorage::seal() {
+    CompressedBlock block;
+    block.bounds = tail_bounds[0];
+    BitWriter w(block.bits);
+
+    uint64_t prev_x = bitsOf(tail[0].x());
+    uint64_t prev_y = bitsOf(tail[0].y());
+    w.write(prev_x, 64);
+    w.write(prev_y, 64);
+    uint64_t prev_delta = 0;
+    int lead = -1;
+    int trail = 0;
+    for(size_t i = 1; i < BLOCK; i++) {
+        uint64_t x = bitsOf(tail[i].x());
+        uint64_t delta = x - prev_x;
+        writeDelta(w, delta - prev_delta);
+        prev_delta = delta;
+        prev_x = x;
+
+        uint64_t y = bitsOf(tail[i].y());
+        uint64_t diff = y ^ prev_y;
+        prev_y = y;
+        if(diff == 0) {
+            w.write(0, 1);
+            continue;
+        }
+        int l = min(__builtin_clzll(diff), 31);
+        int t = __builtin_ctzll(diff);
+        if(lead >= 0 && l >= lead && t >= trail) {
+            w.write(2, 2);
+            w.write(diff >> trail, 64 - lead - trail);
+        } else {
+            lead = l;
+            trail = t;
+            int length = 64 - lead - trail;
+            w.write(3, 2);
+            w.write(lead, 5);
+            w.write(length - 1, 6);
+            w.write(diff >> trail, length);
+        }
+    }
+    block.bits.shrink_to_fit();
+    blocks.push_back(std::move(block));
+    tail.erase(tail.begin(), tail.begin() + BLOCK);
+    tail_bounds[0] = tail_bounds[1];
+}
+
+const vector<XYItem>& CompressedStorage::decode(size_t index) const {
+    DecodeCache &c = decode_cache;
+    for(int i = 0; i < DecodeCache::SIZE; i++) {
+        if(c.ids[i] == id && c.blocks[i] == index) return c.items[i];
+    }
+    int slot = c.next;
+    c.next = (c.next + 1) % DecodeCache::SIZE;
+    vector<XYItem> &cache = c.items[slot];
+    const CompressedBlock &block = blocks[index];
+    BitReader r(block.bits.data());
+    cache.clear();
+    cache.reserve(BLOCK);
+
+    uint64_t x = r.read(64);
+    uint64_t y = r.read(64);
+    cache.push_back(XYItem(valueOf(x), valueOf(y)));
+    uint64_t delta = 0;
+    int lead = 0;
+    int trail = 0;
+    for(size_t i = 1; i < BLOCK; i++) {
+        delta += readDelta(r);
+        x += delta;
+        if(r.bit()) {
+            if(r.bit()) {
+                lead = (int)r.read(5);
+                trail = 64 - lead - ((int)r.read(6) + 1);
+            }
+            y ^= r.read(64 - lead - trail) << trail;
+        }
+        cache.push_back(XYItem(valueOf(x), valueOf(y)));
+    }
+    c.ids[slot] = id;
+    c.blocks[slot] = index;
+    return cache;
+}
+
+// Finds the block by its bounds and decodes only that one.
+size_t CompressedStorage::search(qreal x, bool upper) const {
+    size_t lo = 0;
+    size_t hi = blocks.size();
+    while(lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        qreal max_x = blocks[mid].bounds.max_x;
+        if(upper ? max_x <= x : max_x < x) lo = mid + 1;
+        else hi = mid;
+    }
+    const vector<XYItem> &items = lo < blocks.size() ? decode(lo) : tail;
+    size_t i = 0;
+    size_t n = items.size();
+    while(i < n) {
+        size_t mid = i + (n - i) / 2;
+        if(upper ? items[mid].x() <= x : items[mid].x() < x) i = mid + 1;
+        else n = mid;
+    }
+    return lo * BLOCK + i;
+}
+
+size_t CompressedStorage::getMemoryUsage() const {
+    size_t bytes = blocks.capacity() * sizeof(CompressedBlock);
+    for(const CompressedBlock &block : blocks) {
+        bytes += block.bits.capacity() * sizeof(uint64_t);
+    }
+    return bytes + tail.capacity() * sizeof(XYItem);
+}
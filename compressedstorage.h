@@ -0,0 +1,78 @@
+#ifndef COMPRESSEDSTORAGE_H
+#define COMPRESSEDSTORAGE_H
+
+#include "series.h"
+
+class CompressedBlock {
+public:
+    XYBucket bounds;
+    vector<uint64_t> bits;
+};
+
+// In-memory XYStorage that packs samples into compressed blocks of BLOCK
+// samples: x as delta-of-delta of its IEEE bit pattern, y as the XOR with
+// the previous y (the Gorilla scheme). Regularly sampled x costs about a
+// byte per sample, slowly changing or quantized y a few bits.
+//
+// Every block keeps its bounds, exposed as summary level 0, so culling and
+// zoomed-out decimation never decode a block. Samples are appended to an
+// uncompressed tail; once it holds two blocks' worth the older one is
+// sealed, so the last BLOCK to 2 * BLOCK samples stay open for late samples
+// to be merged into. Sealed blocks are never rewritten. Reads decode a
+// whole block and keep the last few per thread, so a sequential scan
+// decodes every block once and any number of threads may read at once
+// while nothing is appended.
+class CompressedStorage : public XYStorage {
+public:
+    constexpr static size_t BLOCK = 1024;
+
+private:
+    vector<CompressedBlock> blocks;
+    vector<XYItem> tail;
+    // Bounds of the tail's first and second BLOCK samples.
+    XYBucket tail_bounds[2];
+    // Keys this storage's blocks in the per-thread decode cache; a new one
+    // after clear().
+    uint64_t id;
+
+    void seal();
+    void extendTail(const XYItem &item);
+    const vector<XYItem>& decode(size_t block) const;
+    size_t search(qreal x, bool upper) const;
+
+public:
+    CompressedStorage();
+
+    size_t size() const {
+        return blocks.size() * BLOCK + tail.size();
+    }
+    XYItem at(size_t index) const {
+        size_t block = index / BLOCK;
+        if(block >= blocks.size()) return tail[index - blocks.size() * BLOCK];
+        return decode(block)[index % BLOCK];
+    }
+    void append(const XYItem& item);
+    void insert(size_t index, const XYItem* items, size_t count);
+    size_t getInsertFloor() const {
+        return blocks.size() * BLOCK;
+    }
+    void clear();
+    size_t lowerBound(qreal x) const {
+        return search(x, false);
+    }
+    size_t upperBound(qreal x) const {
+        return search(x, true);
+    }
+    size_t getMemoryUsage() const;
+    int getSummaryLevels() const {
+        return size() > 0 ? 1 : 0;
+    }
+    size_t getSummaryBucketSize(int) const {
+        return BLOCK;
+    }
+    XYBucket getSummary(int, size_t index) const {
+        return index < blocks.size() ? blocks[index].bounds : tail_bounds[index - blocks.size()];
+    }
+};
+
+#endif // COMPRESSEDSTORAGE_H
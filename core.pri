@@ -0,0 +1,67 @@
+#-------------------------------------------------
+#
+# Chart engine: axes, series storages, the render and the Chart widget.
+# Shared by the viewer (chart.pro), the chartcore library (chartcore.pro)
+# and anything that wants to compile it in directly.
+#
+#-------------------------------------------------
+
+QT       += core gui network svg
+
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+
+CONFIG += c++17
+
+INCLUDEPATH += $$PWD
+DEPENDPATH += $$PWD
+
+SOURCES += \
+    $$PWD/chart.cpp \
+    $$PWD/axis.cpp \
+    $$PWD/range.cpp \
+    $$PWD/series.cpp \
+    $$PWD/render.cpp \
+    $$PWD/shmstorage.cpp \
+    $$PWD/streamsource.cpp \
+    $$PWD/mappedstorage.cpp \
+    $$PWD/csvloader.cpp \
+    $$PWD/compressedstorage.cpp \
+    $$PWD/tieredstorage.cpp \
+    $$PWD/recorder.cpp \
+    $$PWD/parallelsort.cpp \
+    $$PWD/pickgrid.cpp \
+    $$PWD/frameprofiler.cpp \
+    $$PWD/vectorexport.cpp \
+    $$PWD/densitygrid.cpp \
+    $$PWD/barcache.cpp \
+    $$PWD/derivedseries.cpp
+
+HEADERS += \
+    $$PWD/chart.h \
+    $$PWD/axis.h \
+    $$PWD/range.h \
+    $$PWD/type.h \
+    $$PWD/series.h \
+    $$PWD/render.h \
+    $$PWD/shmring.h \
+    $$PWD/shmstorage.h \
+    $$PWD/streamframe.h \
+    $$PWD/streamsource.h \
+    $$PWD/seriesfile.h \
+    $$PWD/mappedstorage.h \
+    $$PWD/csvloader.h \
+    $$PWD/compressedstorage.h \
+    $$PWD/tieredstorage.h \
+    $$PWD/recordfile.h \
+    $$PWD/recorder.h \
+    $$PWD/parallelsort.h \
+    $$PWD/pickgrid.h \
+    $$PWD/frameprofiler.h \
+    $$PWD/renderstats.h \
+    $$PWD/vectorexport.h \
+    $$PWD/densitygrid.h \
+    $$PWD/barcache.h \
+    $$PWD/derivedseries.h \
+    $$PWD/numericlocale.h
+
+unix: LIBS += -lrt
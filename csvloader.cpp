@@ -0,0 +1,147 @@
+#include "csvloader.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <charconv>
+#include <cstring>
+#include <thread>
+
+namespace {
+
+class CsvChunk {
+public:
+    const char *begin;
+    const char *end;
+    vector<XYItem> items;
+    size_t skipped;
+    bool sorted;
+
+public:
+    CsvChunk() : begin(nullptr), end(nullptr), skipped(0), sorted(true) {}
+};
+
+inline bool parseField(const char *begin, const char *end, qreal &value) {
+    while(begin < end && (*begin == ' ' || *begin == '\t')) begin++;
+    while(end > begin && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r')) end--;
+    if(begin < end && *begin == '+') begin++;
+    if(begin == end) return false;
+    double v;
+    std::from_chars_result r = std::from_chars(begin, end, v);
+    if(r.ec != std::errc() || r.ptr != end) return false;
+    value = v;
+    return true;
+}
+
+void parseChunk(CsvChunk &chunk, int x_column, int y_column, char delimiter) {
+    const char *p = chunk.begin;
+    chunk.items.reserve((chunk.end - chunk.begin) / 16);
+    while(p < chunk.end) {
+        const char *eol = static_cast<const char*>(memchr(p, '\n', chunk.end - p));
+        if(!eol) eol = chunk.end;
+
+        qreal x = 0;
+        qreal y = 0;
+        bool has_x = false;
+        bool has_y = false;
+        int column = 0;
+        const char *field = p;
+        while(field <= eol && !(has_x && has_y)) {
+            const char *next = static_cast<const char*>(memchr(field, delimiter, eol - field));
+            if(!next) next = eol;
+            if(column == x_column) has_x = parseField(field, next, x);
+            if(column == y_column) has_y = parseField(field, next, y);
+            if(next == eol) break;
+            field = next + 1;
+            column++;
+        }
+        if(has_x && has_y) {
+            if(!chunk.items.empty() && !(chunk.items.back().x() < x)) chunk.sorted = false;
+            chunk.items.push_back(XYItem(x, y));
+        } else {
+            chunk.skipped++;
+        }
+        p = eol + 1;
+    }
+}
+
+}
+
+vector<XYItem> CsvLoader::parse() {
+    int fd = ::open(path.toLocal8Bit().constData(), O_RDONLY);
+    if(fd < 0) throw 1;
+    struct stat st;
+    if(fstat(fd, &st) < 0) {
+        ::close(fd);
+        throw 1;
+    }
+    size_t length = st.st_size;
+    skipped = 0;
+    sorted = true;
+    if(length == 0) {
+        ::close(fd);
+        return vector<XYItem>();
+    }
+    void *base = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if(base == MAP_FAILED) throw 1;
+    madvise(base, length, MADV_SEQUENTIAL);
+
+    const char *data = static_cast<const char*>(base);
+    const char *end = data + length;
+
+    size_t count = threads > 0 ? threads : max(1u, std::thread::hardware_concurrency());
+    count = min(count, length / (1 << 20) + 1);
+
+    vector<CsvChunk> chunks(count);
+    const char *p = data;
+    for(size_t i = 0; i < count; i++) {
+        chunks[i].begin = p;
+        if(i + 1 == count) {
+            p = end;
+        } else {
+            p = max(p, data + length / count * (i + 1));
+            const char *eol = static_cast<const char*>(memchr(p, '\n', end - p));
+            p = eol ? eol + 1 : end;
+        }
+        chunks[i].end = p;
+    }
+
+    vector<std::thread> workers;
+    for(size_t i = 1; i < count; i++) {
+        workers.push_back(std::thread(parseChunk, std::ref(chunks[i]), x_column, y_column, delimiter));
+    }
+    parseChunk(chunks[0], x_column, y_column, delimiter);
+    for(std::thread &t : workers) t.join();
+    munmap(base, length);
+
+    vector<size_t> offsets(count + 1, 0);
+    const XYItem *last = nullptr;
+    for(size_t i = 0; i < count; i++) {
+        offsets[i+1] = offsets[i] + chunks[i].items.size();
+        skipped += chunks[i].skipped;
+        if(!chunks[i].sorted) sorted = false;
+        if(chunks[i].items.empty()) continue;
+        if(last && !(*last < chunks[i].items.front())) sorted = false;
+        last = &chunks[i].items.back();
+    }
+
+    vector<XYItem> items(offsets[count], XYItem(0, 0));
+    workers.clear();
+    for(size_t i = 0; i < count; i++) {
+        workers.push_back(std::thread([&chunks, &items, &offsets, i]() {
+            std::copy(chunks[i].items.begin(), chunks[i].items.end(), items.begin() + offsets[i]);
+            vector<XYItem>().swap(chunks[i].items);
+        }));
+    }
+    for(std::thread &t : workers) t.join();
+    return items;
+}
+
+size_t CsvLoader::load(XYSeries *series, bool notify) {
+    vector<XYItem> items = parse();
+    series->addAll(items, notify);
+    return items.size();
+}
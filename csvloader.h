@@ -0,0 +1,50 @@
+#ifndef CSVLOADER_H
+#define CSVLOADER_H
+
+#include "series.h"
+
+// Loads x/y columns of a delimited text file into an XYSeries. The file is
+// mapped, cut into one chunk per thread at line boundaries, and each chunk
+// is parsed with std::from_chars; the chunks are then stitched back in file
+// order and appended as a single batch.
+//
+// Lines whose x or y field doesn't parse (headers, comments, blanks) are
+// skipped and counted.
+class CsvLoader {
+private:
+    QString path;
+    int x_column;
+    int y_column;
+    char delimiter;
+    int threads;
+    size_t skipped;
+    bool sorted;
+
+public:
+    CsvLoader(QString _path) : path(_path), x_column(0), y_column(1), delimiter(','), threads(0), skipped(0), sorted(true) {
+
+    }
+    void setColumns(int x, int y) {
+        if(x < 0 || y < 0) throw 1;
+        x_column = x;
+        y_column = y;
+    }
+    void setDelimiter(char delimiter) {
+        this->delimiter = delimiter;
+    }
+    // 0 picks one thread per core.
+    void setThreads(int threads) {
+        this->threads = threads;
+    }
+    size_t getSkippedLines() const {
+        return skipped;
+    }
+    // Whether x was strictly increasing in the last parse().
+    bool isSorted() const {
+        return sorted;
+    }
+    vector<XYItem> parse();
+    size_t load(XYSeries *series, bool notify = true);
+};
+
+#endif // CSVLOADER_H
@@ -0,0 +1,176 @@
+#include "densitygrid.h"
+
+#include <cmath>
+#include <thread>
+
+namespace {
+
+QVector<QColor> stopsOf(const char *const *names, int count) {
+    QVector<QColor> stops;
+    for(int i = 0; i < count; i++) stops.append(QColor(names[i]));
+    return stops;
+}
+
+}
+
+DensityColormap::DensityColormap() : DensityColormap(viridis()) {
+
+}
+
+DensityColormap::DensityColormap(const QVector<QColor> &stops) {
+    if(stops.size() < 2) throw 1;
+    table.resize(SIZE);
+    for(int i = 0; i < SIZE; i++) {
+        qreal t = qreal(i) / (SIZE - 1) * (stops.size() - 1);
+        int k = min((int)t, stops.size() - 2);
+        qreal f = t - k;
+        const QColor &a = stops[k];
+        const QColor &b = stops[k + 1];
+        table[i] = qRgb((int)(a.red() + (b.red() - a.red()) * f + 0.5),
+                        (int)(a.green() + (b.green() - a.green()) * f + 0.5),
+                        (int)(a.blue() + (b.blue() - a.blue()) * f + 0.5));
+    }
+}
+
+DensityColormap DensityColormap::viridis() {
+    static const char *const names[] = { "#440154", "#482878", "#3e4989", "#31688e", "#26828e", "#1f9e89", "#35b779", "#6ece58", "#b5de2b", "#fde725" };
+    return DensityColormap(stopsOf(names, 10));
+}
+
+DensityColormap DensityColormap::heat() {
+    static const char *const names[] = { "#400000", "#b00000", "#ff4000", "#ffb000", "#ffff80" };
+    return DensityColormap(stopsOf(names, 5));
+}
+
+DensityColormap DensityColormap::gray() {
+    static const char *const names[] = { "#c0c0c0", "#000000" };
+    return DensityColormap(stopsOf(names, 2));
+}
+
+bool DensityGrid::isValid(Axis *domain, Axis *range, QRectF area, QRect bounds, qreal ratio) const {
+    Range d = domain->getRange();
+    Range r = range->getRange();
+    return width > 0 && this->area == area && this->bounds == bounds && this->ratio == ratio
+            && domain_min == d.min() && domain_max == d.max()
+            && range_min == r.min() && range_max == r.max()
+            && domain_invert == domain->isInvert() && range_invert == range->isInvert();
+}
+
+// Axes are linear, so a sample maps to the grid as origin plus scale
+// times its offset from the axis minimum.
+void DensityGrid::reset(Axis *domain, Pos domain_pos, Axis *range, Pos range_pos, QRectF area, QRect bounds, qreal ratio, size_t first, size_t stride) {
+    this->area = area;
+    this->bounds = bounds;
+    this->ratio = ratio;
+    domain_min = domain->getRange().min();
+    domain_max = domain->getRange().max();
+    range_min = range->getRange().min();
+    range_max = range->getRange().max();
+    domain_invert = domain->isInvert();
+    range_invert = range->isInvert();
+
+    qreal x0 = domain->value_to_point(domain_min, area, domain_pos);
+    qreal x1 = domain->value_to_point(domain_max, area, domain_pos);
+    qreal y0 = range->value_to_point(range_min, area, range_pos);
+    qreal y1 = range->value_to_point(range_max, area, range_pos);
+    ax = domain_max > domain_min ? (x1 - x0) / (domain_max - domain_min) * ratio : 0;
+    bx = (x0 - bounds.left()) * ratio;
+    ay = range_max > range_min ? (y1 - y0) / (range_max - range_min) * ratio : 0;
+    by = (y0 - bounds.top()) * ratio;
+
+    width = max(0, (int)ceil(bounds.width() * ratio));
+    height = max(0, (int)ceil(bounds.height() * ratio));
+    counts.assign((size_t)width * height, 0);
+    this->first = first;
+    next = first;
+    scanned = first;
+    this->stride = max<size_t>(1, stride);
+    max_count = 0;
+    image_valid = false;
+}
+
+void DensityGrid::count(const XYItem *items, size_t from, size_t to, quint32 *grid) const {
+    quint32 weight = (quint32)stride;
+    for(size_t i = from; i < to; i += stride) {
+        qreal gx = ax * (items[i].x() - domain_min) + bx;
+        qreal gy = ay * (items[i].y() - range_min) + by;
+        if(!(gx >= 0 && gx < width && gy >= 0 && gy < height)) continue;
+        grid[(size_t)gy * width + (size_t)gx] += weight;
+    }
+}
+
+void DensityGrid::countAt(XYStorage *storage, size_t from, size_t to, quint32 *grid) const {
+    quint32 weight = (quint32)stride;
+    for(size_t i = from; i < to; i += stride) {
+        XYItem item = storage->at(i);
+        qreal gx = ax * (item.x() - domain_min) + bx;
+        qreal gy = ay * (item.y() - range_min) + by;
+        if(!(gx >= 0 && gx < width && gy >= 0 && gy < height)) continue;
+        grid[(size_t)gy * width + (size_t)gx] += weight;
+    }
+}
+
+void DensityGrid::bin(XYStorage *storage, size_t last, int threads) {
+    if(width == 0 || height == 0 || next >= last) {
+        scanned = max(scanned, last);
+        return;
+    }
+    size_t samples = (last - next + stride - 1) / stride;
+    const XYItem *items = storage->data();
+    size_t count_threads = threads > 0 ? threads : max(1u, std::thread::hardware_concurrency());
+    count_threads = min(count_threads, samples / PARALLEL_MIN + 1);
+
+    if(!items) {
+        countAt(storage, next, last, counts.data());
+    } else if(count_threads == 1) {
+        count(items, next, last, counts.data());
+    } else {
+        // Every thread counts a slice into its own grid; the grids are
+        // then summed, each thread taking a band of cells.
+        size_t cells = counts.size();
+        vector<vector<quint32>> partial(count_threads - 1, vector<quint32>(cells, 0));
+        vector<std::thread> workers;
+        for(size_t t = 0; t < count_threads; t++) {
+            size_t from = next + samples * t / count_threads * stride;
+            size_t to = min(last, next + samples * (t + 1) / count_threads * stride);
+            quint32 *grid = t == 0 ? counts.data() : partial[t - 1].data();
+            workers.push_back(std::thread([this, items, from, to, grid]() {
+                count(items, from, to, grid);
+            }));
+        }
+        for(std::thread &worker : workers) worker.join();
+        workers.clear();
+        for(size_t t = 0; t < count_threads; t++) {
+            size_t from = cells * t / count_threads;
+            size_t to = cells * (t + 1) / count_threads;
+            workers.push_back(std::thread([this, &partial, from, to]() {
+                for(const vector<quint32> &grid : partial) {
+                    for(size_t c = from; c < to; c++) counts[c] += grid[c];
+                }
+            }));
+        }
+        for(std::thread &worker : workers) worker.join();
+    }
+    next += samples * stride;
+    scanned = last;
+    max_count = counts.empty() ? 0 : *max_element(counts.begin(), counts.end());
+    image_valid = false;
+}
+
+// Log scale, so sparse outliers still show next to dense cores.
+const QImage& DensityGrid::toImage(const DensityColormap &colormap) {
+    if(image_valid) return image;
+    image = QImage(max(1, width), max(1, height), QImage::Format_ARGB32_Premultiplied);
+    image.setDevicePixelRatio(ratio);
+    image.fill(Qt::transparent);
+    qreal scale = max_count > 1 ? 1 / log1p((qreal)max_count) : 1;
+    for(int y = 0; y < height; y++) {
+        QRgb *line = reinterpret_cast<QRgb*>(image.scanLine(y));
+        const quint32 *row = counts.data() + (size_t)y * width;
+        for(int x = 0; x < width; x++) {
+            if(row[x]) line[x] = colormap.map(log1p((qreal)row[x]) * scale);
+        }
+    }
+    image_valid = true;
+    return image;
+}
@@ -0,0 +1,102 @@
+#ifndef DENSITYGRID_H
+#define DENSITYGRID_H
+
+#include <QColor>
+#include <QImage>
+#include <QRect>
+#include <QVector>
+
+#include "axis.h"
+#include "series.h"
+
+// Maps a density in [0, 1] to a color, through a table interpolated
+// between evenly spaced stops. A density of 0 stays transparent.
+class DensityColormap {
+public:
+    constexpr static int SIZE = 256;
+
+private:
+    QVector<QRgb> table;
+
+public:
+    DensityColormap();
+    DensityColormap(const QVector<QColor> &stops);
+    QRgb map(qreal density) const {
+        int i = (int)(density * (SIZE - 1) + 0.5);
+        return table[i < 0 ? 0 : i >= SIZE ? SIZE - 1 : i];
+    }
+
+    static DensityColormap viridis();
+    static DensityColormap heat();
+    static DensityColormap gray();
+};
+
+// Sample counts per device pixel of one series over one view, drawn as a
+// single image through a colormap on a log scale. bin() only counts the
+// samples it hasn't seen yet, so a view that keeps its axes only pays for
+// what was appended since. Large scans are split across threads, each
+// counting into its own grid; they need a storage with data().
+//
+// With a stride above 1 only every stride-th sample is counted, weighted
+// by the stride, for drafts of huge series.
+class DensityGrid {
+public:
+    constexpr static size_t PARALLEL_MIN = 1 << 16;
+
+private:
+    QRectF area;
+    QRect bounds;
+    qreal ratio;
+    qreal domain_min;
+    qreal domain_max;
+    qreal range_min;
+    qreal range_max;
+    bool domain_invert;
+    bool range_invert;
+    qreal ax;
+    qreal bx;
+    qreal ay;
+    qreal by;
+    int width;
+    int height;
+    size_t first;
+    size_t next;
+    size_t scanned;
+    size_t stride;
+    vector<quint32> counts;
+    quint32 max_count;
+    QImage image;
+    bool image_valid;
+
+    void count(const XYItem *items, size_t from, size_t to, quint32 *grid) const;
+    void countAt(XYStorage *storage, size_t from, size_t to, quint32 *grid) const;
+
+public:
+    DensityGrid() : ratio(1), domain_min(0), domain_max(0), range_min(0), range_max(0), domain_invert(false), range_invert(false),
+        ax(0), bx(0), ay(0), by(0), width(0), height(0), first(0), next(0), scanned(0), stride(1), max_count(0), image_valid(false) {}
+    // Whether the counts still belong to the view.
+    bool isValid(Axis *domain, Axis *range, QRectF area, QRect bounds, qreal ratio) const;
+    // Starts over for the view, counting from index first on.
+    void reset(Axis *domain, Pos domain_pos, Axis *range, Pos range_pos, QRectF area, QRect bounds, qreal ratio, size_t first, size_t stride);
+    // Counts the samples of storage up to index last not counted yet.
+    void bin(XYStorage *storage, size_t last, int threads = 0);
+    // Samples up to here have been looked at.
+    size_t getScanned() const {
+        return scanned;
+    }
+    size_t getStride() const {
+        return stride;
+    }
+    size_t getFirst() const {
+        return first;
+    }
+    quint32 getMaxCount() const {
+        return max_count;
+    }
+    void invalidateImage() {
+        image_valid = false;
+    }
+    const QImage& toImage(const DensityColormap &colormap);
+};
+
+#endif // DENSITYGRID_H
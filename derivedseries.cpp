@@ -0,0 +1,116 @@
+#include "derivedseries.h"
+
+#include <cmath>
+
+void MovingAverage::reset() {
+    next = 0;
+    count = 0;
+    sum = 0;
+}
+
+void MovingAverage::apply(const XYItem &item, vector<XYItem> &out) {
+    if(count == window) sum -= ys[next];
+    else count++;
+    ys[next] = item.y();
+    sum += item.y();
+    next = (next + 1) % window;
+    if(next == 0) {
+        sum = 0;
+        for(size_t i = 0; i < count; i++) sum += ys[i];
+    }
+    if(count == window) out.push_back(XYItem(item.x(), sum / window));
+}
+
+void RollingStd::reset() {
+    next = 0;
+    count = 0;
+    mean = 0;
+    m2 = 0;
+}
+
+void RollingStd::apply(const XYItem &item, vector<XYItem> &out) {
+    if(count == window) {
+        qreal old = ys[next];
+        qreal delta = old - mean;
+        mean -= delta / (count - 1);
+        m2 -= delta * (old - mean);
+        count--;
+    }
+    qreal y = item.y();
+    count++;
+    qreal delta = y - mean;
+    mean += delta / count;
+    m2 += delta * (y - mean);
+    if(m2 < 0) m2 = 0;
+    ys[next] = y;
+    next = (next + 1) % window;
+    if(next == 0) {
+        mean = 0;
+        for(size_t i = 0; i < count; i++) mean += ys[i];
+        mean /= count;
+        m2 = 0;
+        for(size_t i = 0; i < count; i++) m2 += (ys[i] - mean) * (ys[i] - mean);
+    }
+    if(count == window) out.push_back(XYItem(item.x(), sqrt(m2 / (count - 1))));
+}
+
+void RateOfChange::reset() {
+    started = false;
+}
+
+void RateOfChange::apply(const XYItem &item, vector<XYItem> &out) {
+    if(started && item.x() != last.x()) {
+        out.push_back(XYItem(item.x(), (item.y() - last.y()) / (item.x() - last.x())));
+    }
+    if(!started || item.x() != last.x()) last = item;
+    started = true;
+}
+
+void Decimation::reset() {
+    count = 0;
+    sum_x = 0;
+    sum_y = 0;
+}
+
+void Decimation::apply(const XYItem &item, vector<XYItem> &out) {
+    sum_x += item.x();
+    sum_y += item.y();
+    if(++count < factor) return;
+    out.push_back(XYItem(sum_x / factor, sum_y / factor));
+    reset();
+}
+
+size_t DerivedStorage::sync() {
+    if(!pending) return 0;
+    if(source->getStorage()->isPending()) source->sync(false);
+    size_t count = source->getCount();
+    quint64 appended = source->getAppendedCount();
+    // The new samples are the last fresh ones, unless they are all there is.
+    size_t fresh = (size_t)min<quint64>(appended - consumed, count);
+    if(restart || count < seen || fresh == count) {
+        items.clear();
+        op->reset();
+        fresh = count;
+        restart = false;
+    }
+    size_t before = items.size();
+    XYStorage *storage = source->getStorage();
+    for(size_t i = count - fresh; i < count; i++) {
+        op->apply(storage->at(i), items);
+    }
+    consumed = appended;
+    seen = count;
+    pending = false;
+    return items.size() - before;
+}
+
+void DerivedSeries::onSeriesChanged(const SeriesChangeEvent*) {
+    derived->invalidate(source->getCount() < derived->getSeen());
+    fire();
+}
+
+// Samples appended at the end, to a ring storage too, are picked up where
+// the last sync stopped; anything landing before them starts over.
+void DerivedSeries::onSeriesAppended(const SeriesAppendEvent* event) {
+    derived->invalidate(event->index + event->count < source->getCount());
+}
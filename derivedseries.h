@@ -0,0 +1,191 @@
+#ifndef DERIVEDSERIES_H
+#define DERIVEDSERIES_H
+
+#include <memory>
+
+#include "series.h"
+
+// Turns source samples, in order, into derived samples. apply() sees every
+// source sample exactly once and may emit any number of samples; it must
+// run in O(1) amortized so a derived series costs the same per appended
+// sample however long its history is.
+class DerivedOperator {
+public:
+    virtual ~DerivedOperator() {}
+    virtual void reset() = 0;
+    virtual void apply(const XYItem &item, vector<XYItem> &out) = 0;
+};
+
+// Mean of the last window samples, from the window-th sample on. The
+// running sum is rebuilt from the window every window samples so rounding
+// errors don't pile up.
+class MovingAverage : public DerivedOperator {
+private:
+    size_t window;
+    vector<qreal> ys;
+    size_t next;
+    size_t count;
+    qreal sum;
+
+public:
+    MovingAverage(size_t _window) : window(_window), ys(_window), next(0), count(0), sum(0) {
+        if(window == 0) throw 1;
+    }
+    void reset();
+    void apply(const XYItem &item, vector<XYItem> &out);
+};
+
+// Sample standard deviation of the last window samples, with Welford's
+// update for the sample entering the window and its inverse for the one
+// leaving it. Like MovingAverage's sum, mean and m2 are rebuilt from the
+// window every window samples.
+class RollingStd : public DerivedOperator {
+private:
+    size_t window;
+    vector<qreal> ys;
+    size_t next;
+    size_t count;
+    qreal mean;
+    qreal m2;
+
+public:
+    RollingStd(size_t _window) : window(_window), ys(_window), next(0), count(0), mean(0), m2(0) {
+        if(window < 2) throw 1;
+    }
+    void reset();
+    void apply(const XYItem &item, vector<XYItem> &out);
+};
+
+// dy/dx between consecutive samples, at the later one. Samples sharing the
+// x before them are skipped.
+class RateOfChange : public DerivedOperator {
+private:
+    bool started;
+    XYItem last;
+
+public:
+    RateOfChange() : started(false), last(0, 0) {}
+    void reset();
+    void apply(const XYItem &item, vector<XYItem> &out);
+};
+
+// Mean x and y of every factor consecutive samples; a trailing partial
+// group is held back until it fills up.
+class Decimation : public DerivedOperator {
+private:
+    size_t factor;
+    size_t count;
+    qreal sum_x;
+    qreal sum_y;
+
+public:
+    Decimation(size_t _factor) : factor(_factor), count(0), sum_x(0), sum_y(0) {
+        if(factor == 0) throw 1;
+    }
+    void reset();
+    void apply(const XYItem &item, vector<XYItem> &out);
+};
+
+// Read-only storage holding what an operator made of a source series. It
+// does no work when the source changes, only remembers that it has to:
+// sync() then runs the operator over the source samples it hasn't seen,
+// counted by the source's getAppendedCount() so a ring storage turning over
+// costs no more than any other append. Samples landing in the middle (late
+// samples), a source that shrank, or one that moved on by more than it
+// holds make it start over from the beginning.
+class DerivedStorage : public XYStorage {
+private:
+    XYSeries *source;
+    unique_ptr<DerivedOperator> op;
+    vector<XYItem> items;
+    // The source's appended count and sample count as of the last sync.
+    quint64 consumed;
+    size_t seen;
+    bool pending;
+    bool restart;
+
+public:
+    DerivedStorage(XYSeries *_source, DerivedOperator *_op) : source(_source), op(_op), consumed(0), seen(0), pending(true), restart(false) {
+        if(!source || !op) throw 1;
+    }
+    size_t size() const {
+        return items.size();
+    }
+    XYItem at(size_t index) const {
+        return items[index];
+    }
+    void append(const XYItem&) {
+        throw 1;
+    }
+    void clear() {
+        items.clear();
+        invalidate(true);
+    }
+    const XYItem* data() const {
+        return items.data();
+    }
+    size_t getMemoryUsage() const {
+        return items.capacity() * sizeof(XYItem);
+    }
+    bool isPending() const {
+        return pending;
+    }
+    size_t sync();
+    XYSeries* getSource() const {
+        return source;
+    }
+    size_t getSeen() const {
+        return seen;
+    }
+    void invalidate(bool restart) {
+        pending = true;
+        if(restart) this->restart = true;
+    }
+};
+
+// A series computed from another one. It listens to its source and passes
+// changes on to its own listeners without computing anything; the samples
+// are brought up to date by sync(), which XYRender calls before painting a
+// series that is pending. A derived series nobody draws or syncs costs
+// nothing but the notifications. Derived series can be chained.
+//
+// The source must outlive the derived series; XYRender deletes its series
+// last added first, so adding the source before is enough there.
+class DerivedSeries : public XYSeries, SeriesChangeListener, SeriesAppendListener {
+private:
+    XYSeries *source;
+    DerivedStorage *derived;
+
+public:
+    DerivedSeries(QString name, XYSeries *source, DerivedOperator *op) : DerivedSeries(name, new DerivedStorage(source, op)) {}
+    ~DerivedSeries() {
+        source->removeSeriesChangeListener(this);
+        source->removeSeriesAppendListener(this);
+    }
+    XYSeries* getSource() const {
+        return source;
+    }
+    void onSeriesChanged(const SeriesChangeEvent* event);
+    void onSeriesAppended(const SeriesAppendEvent* event);
+
+    static DerivedSeries* movingAverage(XYSeries *source, size_t window) {
+        return new DerivedSeries(QString("%1 avg(%2)").arg(source->getName()).arg(window), source, new MovingAverage(window));
+    }
+    static DerivedSeries* rollingStd(XYSeries *source, size_t window) {
+        return new DerivedSeries(QString("%1 std(%2)").arg(source->getName()).arg(window), source, new RollingStd(window));
+    }
+    static DerivedSeries* rateOfChange(XYSeries *source) {
+        return new DerivedSeries(QString("%1 rate").arg(source->getName()), source, new RateOfChange());
+    }
+    static DerivedSeries* decimation(XYSeries *source, size_t factor) {
+        return new DerivedSeries(QString("%1 /%2").arg(source->getName()).arg(factor), source, new Decimation(factor));
+    }
+
+private:
+    DerivedSeries(QString name, DerivedStorage *storage) : XYSeries(name, storage, storage->getSource()->isSorted()), source(storage->getSource()), derived(storage) {
+        source->addSeriesChangeListener(this);
+        source->addSeriesAppendListener(this);
+    }
+};
+
+#endif // DERIVEDSERIES_H
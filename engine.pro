@@ -0,0 +1,32 @@
+#-------------------------------------------------
+#
+# Builds the chartcore library and everything linked against it:
+#   qmake engine.pro && make && make check
+#
+#-------------------------------------------------
+
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    chartcore \
+    chartbench \
+    chartreplay \
+    chartbatch \
+    compressedstoragetest \
+    memorystoragetest
+
+chartcore.file = chartcore.pro
+chartbench.subdir = tools/chartbench
+chartbench.depends = chartcore
+
+chartreplay.subdir = tools/chartreplay
+chartreplay.depends = chartcore
+
+chartbatch.subdir = tools/chartbatch
+chartbatch.depends = chartcore
+
+compressedstoragetest.subdir = tests/compressedstorage
+compressedstoragetest.depends = chartcore
+
+memorystoragetest.subdir = tests/memorystorage
+memorystoragetest.depends = chartcore
@@ -0,0 +1,62 @@
+#include "frameprofiler.h"
+#include "numericlocale.h"
+
+#include <algorithm>
+#include <cstdio>
+
+void FrameProfiler::add(int phase, chrono::steady_clock::time_point start, chrono::steady_clock::time_point end) {
+    quint64 duration = chrono::duration_cast<chrono::nanoseconds>(end - start).count();
+    vector<quint64> &window = samples[phase];
+    if(window.size() < WINDOW) {
+        window.push_back(duration);
+    } else {
+        window[next[phase]] = duration;
+    }
+    next[phase] = (next[phase] + 1) % WINDOW;
+    if(capturing && events.size() < CAPTURE_LIMIT) {
+        quint64 offset = start > capture_start ? chrono::duration_cast<chrono::nanoseconds>(start - capture_start).count() : 0;
+        events.push_back(ProfileEvent(phase, offset, duration));
+    }
+}
+
+double FrameProfiler::getPercentile(int phase, double p) const {
+    vector<quint64> sorted = samples[phase];
+    if(sorted.empty()) return 0;
+    size_t k = min(sorted.size() - 1, (size_t)(p * (sorted.size() - 1) + 0.5));
+    nth_element(sorted.begin(), sorted.begin() + k, sorted.end());
+    return sorted[k] / 1e6;
+}
+
+const char* FrameProfiler::getPhaseName(int phase) {
+    static const char* names[PHASES] = { "frame", "layout", "auto range", "axes", "series", "overlay" };
+    return phase >= 0 && phase < PHASES ? names[phase] : "?";
+}
+
+void FrameProfiler::startCapture() {
+    events.clear();
+    capture_start = chrono::steady_clock::now();
+    capturing = true;
+}
+
+bool FrameProfiler::writeTrace(QString path) const {
+    FILE *file = fopen(path.toLocal8Bit().constData(), "w");
+    if(!file) return false;
+    CNumericLocale c;
+    fprintf(file, "{\"traceEvents\":[\n");
+    for(size_t i = 0; i < events.size(); i++) {
+        const ProfileEvent &e = events[i];
+        fprintf(file, "{\"name\":\"%s\",\"cat\":\"render\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}%s\n",
+                getPhaseName(e.phase), e.start_ns / 1e3, e.duration_ns / 1e3, i + 1 < events.size() ? "," : "");
+    }
+    fprintf(file, "],\"displayTimeUnit\":\"ms\"}\n");
+    bool ok = !ferror(file);
+    return fclose(file) == 0 && ok;
+}
+
+void FrameProfiler::reset() {
+    for(int phase = 0; phase < PHASES; phase++) {
+        samples[phase].clear();
+        next[phase] = 0;
+    }
+    events.clear();
+}
@@ -0,0 +1,96 @@
+#ifndef FRAMEPROFILER_H
+#define FRAMEPROFILER_H
+
+#include <QString>
+
+#include <chrono>
+#include <vector>
+
+using namespace std;
+
+class FrameProfiler;
+
+// Duration of one phase of one frame, relative to when capture started.
+class ProfileEvent {
+public:
+    int phase;
+    quint64 start_ns;
+    quint64 duration_ns;
+
+public:
+    ProfileEvent(int _phase, quint64 _start_ns, quint64 _duration_ns) : phase(_phase), start_ns(_start_ns), duration_ns(_duration_ns) {}
+};
+
+// Times the phases of XYRender frames on the monotonic clock. Every phase
+// keeps its last WINDOW durations for percentiles; between startCapture()
+// and stopCapture() every duration is also kept as an event that
+// writeTrace() saves in the Chrome trace-event format (chrome://tracing,
+// Perfetto). Disabled, a phase costs one branch.
+class FrameProfiler {
+public:
+    enum Phase { FRAME, LAYOUT, AUTO_RANGE, AXES, SERIES, OVERLAY, PHASES };
+    constexpr static size_t WINDOW = 256;
+    constexpr static size_t CAPTURE_LIMIT = 1 << 20;
+
+private:
+    bool enabled;
+    bool capturing;
+    chrono::steady_clock::time_point capture_start;
+    vector<quint64> samples[PHASES];
+    size_t next[PHASES];
+    vector<ProfileEvent> events;
+
+public:
+    FrameProfiler() : enabled(false), capturing(false), next() {}
+    void setEnabled(bool enabled) {
+        this->enabled = enabled;
+    }
+    bool isEnabled() const {
+        return enabled;
+    }
+    chrono::steady_clock::time_point begin() const {
+        return enabled ? chrono::steady_clock::now() : chrono::steady_clock::time_point();
+    }
+    void end(int phase, chrono::steady_clock::time_point start) {
+        if(enabled) add(phase, start, chrono::steady_clock::now());
+    }
+    void add(int phase, chrono::steady_clock::time_point start, chrono::steady_clock::time_point end);
+    // p in [0, 1] over the rolling window, in milliseconds.
+    double getPercentile(int phase, double p) const;
+    size_t getSampleCount(int phase) const {
+        return samples[phase].size();
+    }
+    static const char* getPhaseName(int phase);
+    void startCapture();
+    void stopCapture() {
+        capturing = false;
+    }
+    bool isCapturing() const {
+        return capturing;
+    }
+    size_t getEventCount() const {
+        return events.size();
+    }
+    // Writes the captured events as trace-event JSON; false on I/O errors.
+    bool writeTrace(QString path) const;
+    void reset();
+};
+
+// Times the enclosing scope as one phase when the profiler is enabled.
+class ProfileScope {
+private:
+    FrameProfiler &profiler;
+    int phase;
+    bool active;
+    chrono::steady_clock::time_point start;
+
+public:
+    ProfileScope(FrameProfiler &_profiler, int _phase) : profiler(_profiler), phase(_phase), active(_profiler.isEnabled()) {
+        if(active) start = chrono::steady_clock::now();
+    }
+    ~ProfileScope() {
+        if(active) profiler.add(phase, start, chrono::steady_clock::now());
+    }
+};
+
+#endif // FRAMEPROFILER_H
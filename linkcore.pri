@@ -0,0 +1,16 @@
+#-------------------------------------------------
+#
+# Links the chartcore library (chartcore.pro) into a tool or test two
+# levels below the root. The QT modules here must match core.pri, since a
+# static library does not pass its own on to the apps that link it.
+#
+#-------------------------------------------------
+
+QT       += core gui widgets network svg
+
+INCLUDEPATH += $$PWD
+DEPENDPATH += $$PWD
+
+LIBS += -L$$OUT_PWD/../.. -lchartcore
+PRE_TARGETDEPS += $$OUT_PWD/../../libchartcore.a
+unix: LIBS += -lrt
@@ -12,6 +12,57 @@ int main(int argc, char *argv[])
     QApplication a(argc, argv);
 
     MainWindow mw;
+    QStringList args = a.arguments();
+    int shm = args.indexOf("--shm");
+    if(shm >= 0 && shm + 1 < args.size()) {
+        mw.addShmSeries(args[shm + 1]);
+    }
+    int local = args.indexOf("--local");
+    if(local >= 0 && local + 1 < args.size()) {
+        mw.addLocalStreamSeries(args[local + 1]);
+    }
+    int udp = args.indexOf("--udp");
+    if(udp >= 0 && udp + 1 < args.size()) {
+        mw.addUdpStreamSeries(args[udp + 1].toUShort());
+    }
+    int open = args.indexOf("--open");
+    if(open >= 0 && open + 1 < args.size()) {
+        mw.addFileSeries(args[open + 1]);
+    }
+    int csv = args.indexOf("--csv");
+    if(csv >= 0 && csv + 1 < args.size()) {
+        mw.addCsvSeries(args[csv + 1]);
+    }
+    int average = args.indexOf("--average");
+    if(average >= 0 && average + 1 < args.size()) {
+        mw.addMovingAverage(args[average + 1].toInt());
+    }
+    if(args.contains("--density")) {
+        mw.setStyle(SeriesHolder::DENSITY);
+    }
+    if(args.contains("--candles")) {
+        mw.setStyle(SeriesHolder::CANDLES);
+    }
+    if(args.contains("--band")) {
+        mw.setStyle(SeriesHolder::BAND);
+    }
+    if(args.contains("--profile")) {
+        mw.showProfile();
+    }
+    if(args.contains("--crosshair")) {
+        mw.showCrosshair();
+    }
+    if(args.contains("--progressive")) {
+        mw.setProgressive();
+    }
+    int stats = args.indexOf("--stats");
+    if(stats >= 0 && stats + 1 < args.size()) {
+        mw.logStats(args[stats + 1].toInt());
+    }
+    int trace = args.indexOf("--trace");
+    if(trace >= 0 && trace + 1 < args.size()) {
+        mw.traceFrames(args[trace + 1], 10000);
+    }
     mw.show();
 
     return a.exec();
@@ -1,5 +1,10 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
+#include "shmstorage.h"
+#include "mappedstorage.h"
+#include "csvloader.h"
+#include "parallelsort.h"
+#include "derivedseries.h"
 
 #include <QDebug>
 
@@ -95,10 +100,136 @@ MainWindow::MainWindow(QWidget *parent) :
 
 MainWindow::~MainWindow()
 {
+    qDeleteAll(streams);
     delete ui;
     delete chart;
 }
 
+void MainWindow::addShmSeries(QString name)
+{
+    ShmStorage *storage;
+    try {
+        storage = new ShmStorage(name);
+    } catch(int) {
+        qWarning() << "can't open shared-memory ring" << name;
+        return;
+    }
+    render->addSeries(new XYSeries(name, storage), Qt::cyan);
+    chart->setSyncInterval(16);
+}
+
+void MainWindow::addLocalStreamSeries(QString name)
+{
+    XYSeries *s = new XYSeries(name);
+    render->addSeries(s, Qt::cyan);
+    StreamSource *stream = new StreamSource(s);
+    stream->connectToServer(name);
+    streams.append(stream);
+}
+
+void MainWindow::addUdpStreamSeries(quint16 port)
+{
+    XYSeries *s = new XYSeries(QString("udp:%1").arg(port));
+    render->addSeries(s, Qt::cyan);
+    StreamSource *stream = new StreamSource(s);
+    stream->bind(port);
+    streams.append(stream);
+}
+
+void MainWindow::addFileSeries(QString path)
+{
+    MappedStorage *storage;
+    try {
+        storage = new MappedStorage(path);
+    } catch(int) {
+        qWarning() << "can't open series file" << path;
+        return;
+    }
+    render->addSeries(new XYSeries(path, storage, storage->isSorted()), Qt::darkYellow);
+    storage->prefetch();
+    chart->setSyncInterval(16);
+}
+
+void MainWindow::addCsvSeries(QString path)
+{
+    CsvLoader loader(path);
+    vector<XYItem> items;
+    try {
+        items = loader.parse();
+    } catch(int) {
+        qWarning() << "can't read csv file" << path;
+        return;
+    }
+    if(!loader.isSorted()) {
+        parallel_sort(items);
+        size_t dropped = unique_x(items);
+        if(dropped > 0) qWarning() << path << ": dropped" << dropped << "rows repeating an x";
+    }
+    XYSeries *s = new XYSeries(path);
+    s->addAll(items, false);
+    render->addSeries(s, Qt::darkYellow);
+}
+
+void MainWindow::showProfile()
+{
+    render->setDrawProfile(true);
+}
+
+void MainWindow::showCrosshair()
+{
+    render->setDrawCrosshair(true);
+}
+
+void MainWindow::setProgressive()
+{
+    render->setProgressive(true);
+}
+
+// Applies style to every series added so far; bar styles skip unsorted
+// series.
+void MainWindow::setStyle(SeriesHolder::Style style)
+{
+    for(int i = 0; i < render->getSeriesCount(); i++) {
+        if(style != SeriesHolder::DENSITY && style != SeriesHolder::PLOT && !render->getSeries(i)->isSorted()) continue;
+        render->setSeriesStyle(i, style);
+    }
+}
+
+// Smooths the sine; only the samples the timer appends are averaged.
+void MainWindow::addMovingAverage(int window)
+{
+    if(window < 1) {
+        qWarning() << "moving average needs a window of at least one sample, not" << window;
+        return;
+    }
+    render->addSeries(DerivedSeries::movingAverage(series, window), Qt::darkBlue);
+}
+
+void MainWindow::logStats(int msec)
+{
+    chart->setStatsInterval(msec);
+}
+
+// Captures paint phases for msec and writes them as a Chrome trace.
+void MainWindow::traceFrames(QString path, int msec)
+{
+    trace_path = path;
+    render->getProfiler().setEnabled(true);
+    render->getProfiler().startCapture();
+    trace_timer.setSingleShot(true);
+    connect(&trace_timer, SIGNAL(timeout()), this, SLOT(onTraceTimer()));
+    trace_timer.start(msec);
+}
+
+void MainWindow::onTraceTimer()
+{
+    FrameProfiler &profiler = render->getProfiler();
+    profiler.stopCapture();
+    if(!profiler.writeTrace(trace_path)) {
+        qDebug() << "trace: can't write " << trace_path;
+    }
+}
+
 void MainWindow::on_draw_line_stateChanged(int)
 {
     render->setDrawLine(ui->draw_line->isChecked());
@@ -6,6 +6,7 @@
 #include <QTimer>
 
 #include "chart.h"
+#include "streamsource.h"
 
 namespace Ui {
 class MainWindow;
@@ -19,6 +20,19 @@ public:
     explicit MainWindow(QWidget *parent = 0);
     ~MainWindow();
 
+    void addShmSeries(QString name);
+    void addLocalStreamSeries(QString name);
+    void addUdpStreamSeries(quint16 port);
+    void addFileSeries(QString path);
+    void addCsvSeries(QString path);
+    void showProfile();
+    void showCrosshair();
+    void setProgressive();
+    void setStyle(SeriesHolder::Style style);
+    void addMovingAverage(int window);
+    void logStats(int msec);
+    void traceFrames(QString path, int msec);
+
 private:
     Ui::MainWindow *ui;
     Chart *chart;
@@ -27,11 +41,15 @@ private:
     XYSeries *series;
     XYSeries *series2;
     XYRender *render;
+    QList<StreamSource*> streams;
     QTimer timer;
+    QTimer trace_timer;
+    QString trace_path;
     QStringList pos_x_list;
     QStringList pos_y_list;
 public Q_SLOTS:
     void onTimer();
+    void onTraceTimer();
 private slots:
     void on_draw_line_stateChanged(int arg1);
     void on_draw_shape_stateChanged(int arg1);
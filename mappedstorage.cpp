@@ -0,0 +1,73 @@
+#include "mappedstorage.h"
+
+void MappedStorage::prefetch(size_t max_bytes) {
+    if(loader.joinable() || header->count == 0) return;
+    if(max_bytes == 0) max_bytes = PREFETCH_BYTES;
+    chunks = (header->count + CHUNK - 1) / CHUNK;
+    budget = max_bytes / (2 * CHUNK * sizeof(double));
+    loaded.reset(new std::atomic<bool>[chunks]);
+    for(size_t c = 0; c < chunks; c++) {
+        loaded[c].store(false, std::memory_order_relaxed);
+    }
+    loader = std::thread(&MappedStorage::load, this);
+}
+
+// Picks the next chunk to page in: the requested range first, then the
+// sequential read-ahead while it is within budget. Called with lock held.
+bool MappedStorage::nextChunk(size_t &next, size_t &used, size_t &chunk, bool &sequential) {
+    if(focus_first < focus_last) {
+        for(size_t c = focus_first / CHUNK; c <= (focus_last - 1) / CHUNK && c < chunks; c++) {
+            if(!loaded[c].load(std::memory_order_relaxed)) {
+                chunk = c;
+                sequential = false;
+                return true;
+            }
+        }
+        focus_first = focus_last = 0;
+    }
+    while(next < chunks && loaded[next].load(std::memory_order_relaxed)) next++;
+    if(next < chunks && used < budget) {
+        chunk = next;
+        sequential = true;
+        return true;
+    }
+    return false;
+}
+
+void MappedStorage::touch(size_t chunk) {
+    size_t first = chunk * CHUNK;
+    size_t last = min((size_t)header->count, first + CHUNK);
+    long page = sysconf(_SC_PAGESIZE);
+    const double *columns[] = { xs, ys };
+    for(const double *column : columns) {
+        const char *begin = reinterpret_cast<const char*>(column + first);
+        const char *end = reinterpret_cast<const char*>(column + last);
+        const char *aligned = begin - (reinterpret_cast<uintptr_t>(begin) % page);
+        madvise(const_cast<char*>(aligned), end - aligned, MADV_WILLNEED);
+        volatile char sink = 0;
+        for(const char *p = begin; p < end; p += page) {
+            sink = sink + *p;
+        }
+        sink = sink + end[-1];
+    }
+}
+
+void MappedStorage::load() {
+    size_t next = 0;
+    size_t used = 0;
+    for(;;) {
+        size_t chunk;
+        bool sequential;
+        {
+            std::unique_lock<std::mutex> l(lock);
+            wake.wait(l, [&]() {
+                return stopping || nextChunk(next, used, chunk, sequential);
+            });
+            if(stopping) return;
+        }
+        touch(chunk);
+        loaded[chunk].store(true, std::memory_order_release);
+        if(sequential) used++;
+        revision.fetch_add(1, std::memory_order_release);
+    }
+}
@@ -0,0 +1,196 @@
+#ifndef MAPPEDSTORAGE_H
+#define MAPPEDSTORAGE_H
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "series.h"
+#include "seriesfile.h"
+
+// Read-only XYStorage over a memory-mapped series file (see seriesfile.h).
+// Samples and summaries are served straight from the mapping, so only the
+// pages a frame actually looks at become resident.
+//
+// After prefetch() the columns are paged in by a background thread, chunk by
+// chunk, and the render draws anything not yet loaded from the summary
+// pyramid at the head of the file instead of faulting on the GUI thread.
+// Ranges the render asks for are loaded before the sequential read-ahead.
+class MappedStorage : public XYStorage {
+public:
+    constexpr static size_t CHUNK = 1 << 20;
+    constexpr static size_t PREFETCH_BYTES = 64 << 20;
+
+private:
+    QString path;
+    void *base;
+    size_t length;
+    const SeriesFileHeader *header;
+    const double *xs;
+    const double *ys;
+    const SeriesFileBucket *levels[SERIES_FILE_MAX_LEVELS];
+
+    std::thread loader;
+    std::mutex lock;
+    std::condition_variable wake;
+    bool stopping;
+    size_t chunks;
+    size_t budget;
+    size_t focus_first;
+    size_t focus_last;
+    std::unique_ptr<std::atomic<bool>[]> loaded;
+    std::atomic<size_t> revision;
+
+    const char* address(uint64_t offset) const {
+        return static_cast<const char*>(base) + offset;
+    }
+    // Whether count items of size bytes at offset lie inside the mapping
+    // and are aligned for double, without overflowing on hostile headers.
+    bool fits(uint64_t offset, uint64_t count, size_t size) const {
+        return offset % alignof(double) == 0
+                && offset <= length
+                && count <= (length - offset) / size;
+    }
+    bool nextChunk(size_t &next, size_t &used, size_t &chunk, bool &sequential);
+    void touch(size_t chunk);
+    void load();
+
+public:
+    MappedStorage(QString _path) : path(_path), base(MAP_FAILED), length(0), header(nullptr), xs(nullptr), ys(nullptr),
+        stopping(false), chunks(0), budget(0), focus_first(0), focus_last(0), revision(0) {
+        int fd = ::open(path.toLocal8Bit().constData(), O_RDONLY);
+        if(fd < 0) throw 1;
+        struct stat st;
+        if(fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(SeriesFileHeader)) {
+            ::close(fd);
+            throw 1;
+        }
+        length = st.st_size;
+        base = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if(base == MAP_FAILED) throw 1;
+
+        header = static_cast<const SeriesFileHeader*>(base);
+        bool valid = header->magic == SERIES_FILE_MAGIC
+                && header->version == SERIES_FILE_VERSION
+                && header->levels <= SERIES_FILE_MAX_LEVELS
+                && fits(header->x_offset, header->count, sizeof(double))
+                && fits(header->y_offset, header->count, sizeof(double));
+        for(uint32_t l = 0; valid && l < header->levels; l++) {
+            uint64_t size = header->bucket_size[l];
+            valid = size > 0
+                    && header->bucket_count[l] >= header->count / size + (header->count % size != 0)
+                    && fits(header->level_offset[l], header->bucket_count[l], sizeof(SeriesFileBucket));
+        }
+        if(!valid) {
+            munmap(base, length);
+            throw 1;
+        }
+        xs = reinterpret_cast<const double*>(address(header->x_offset));
+        ys = reinterpret_cast<const double*>(address(header->y_offset));
+        for(uint32_t l = 0; l < header->levels; l++) {
+            levels[l] = reinterpret_cast<const SeriesFileBucket*>(address(header->level_offset[l]));
+        }
+    }
+    ~MappedStorage() {
+        if(loader.joinable()) {
+            {
+                std::lock_guard<std::mutex> l(lock);
+                stopping = true;
+            }
+            wake.notify_all();
+            loader.join();
+        }
+        munmap(base, length);
+    }
+    // Starts paging the columns in on a background thread. Sequential
+    // read-ahead stops after max_bytes per file (0: PREFETCH_BYTES), so
+    // residency stays close to what is on screen; requested ranges are
+    // always loaded.
+    void prefetch(size_t max_bytes = 0);
+    static XYSeries* openSeries(QString path, QString name) {
+        MappedStorage *storage = new MappedStorage(path);
+        return new XYSeries(name, storage, storage->isSorted());
+    }
+    static void save(const XYSeries *series, QString path) {
+        SeriesFileWriter writer(path.toLocal8Bit().constData(), series->getCount(), series->isSorted());
+        for(size_t i = 0; i < series->getCount(); i++) {
+            XYItem item = series->getItem(i);
+            writer.write(item.x(), item.y());
+        }
+        writer.finish();
+    }
+    QString getPath() const {
+        return path;
+    }
+    bool isSorted() const {
+        return header->flags & SERIES_FILE_SORTED;
+    }
+    size_t size() const {
+        return header->count;
+    }
+    XYItem at(size_t index) const {
+        return XYItem(xs[index], ys[index]);
+    }
+    void append(const XYItem&) {
+        throw 1;
+    }
+    void clear() {
+        throw 1;
+    }
+    bool getBounds(XYBucket &bounds) const {
+        if(header->count == 0) return false;
+        bounds.min_x = header->min_x;
+        bounds.max_x = header->max_x;
+        bounds.min_y = header->min_y;
+        bounds.max_y = header->max_y;
+        bounds.first_y = ys[0];
+        bounds.last_y = ys[header->count-1];
+        return true;
+    }
+    int getSummaryLevels() const {
+        return header->levels;
+    }
+    size_t getSummaryBucketSize(int level) const {
+        return header->bucket_size[level];
+    }
+    bool isResident(size_t first, size_t last) const {
+        if(!loaded || first >= last) return true;
+        for(size_t c = first / CHUNK; c <= (last - 1) / CHUNK; c++) {
+            if(!loaded[c].load(std::memory_order_acquire)) return false;
+        }
+        return true;
+    }
+    void request(size_t first, size_t last) {
+        if(!loaded || first >= last) return;
+        {
+            std::lock_guard<std::mutex> l(lock);
+            focus_first = first;
+            focus_last = last;
+        }
+        wake.notify_all();
+    }
+    size_t getResidentRevision() const {
+        return revision.load(std::memory_order_acquire);
+    }
+    XYBucket getSummary(int level, size_t index) const {
+        const SeriesFileBucket &b = levels[level][index];
+        XYBucket bucket;
+        bucket.min_x = b.min_x;
+        bucket.max_x = b.max_x;
+        bucket.min_y = b.min_y;
+        bucket.max_y = b.max_y;
+        bucket.first_y = b.first_y;
+        bucket.last_y = b.last_y;
+        return bucket;
+    }
+};
+
+#endif // MAPPEDSTORAGE_H
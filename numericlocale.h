@@ -0,0 +1,25 @@
+#ifndef NUMERICLOCALE_H
+#define NUMERICLOCALE_H
+
+#include <locale.h>
+
+// Formats numbers on the calling thread in the C locale while in scope.
+// QApplication adopts the user's locale at startup, which would have
+// printf() write 1,5 into files that must say 1.5 (JSON, SVG).
+class CNumericLocale {
+private:
+    locale_t c;
+    locale_t previous;
+
+public:
+    CNumericLocale() : c(newlocale(LC_NUMERIC_MASK, "C", (locale_t)0)), previous((locale_t)0) {
+        if(c) previous = uselocale(c);
+    }
+    ~CNumericLocale() {
+        if(!c) return;
+        uselocale(previous);
+        freelocale(c);
+    }
+};
+
+#endif // NUMERICLOCALE_H
@@ -0,0 +1,83 @@
+#include "parallelsort.h"
+
+#include <thread>
+
+namespace {
+
+// How many samples of a precede output position k when a and b are merged
+// with a winning ties.
+size_t corank(size_t k, const XYItem *a, size_t m, const XYItem *b, size_t n) {
+    size_t lo = k > n ? k - n : 0;
+    size_t hi = min(k, m);
+    while(lo < hi) {
+        size_t i = lo + (hi - lo) / 2;
+        size_t j = k - i;
+        if(j == 0 || i == m || b[j-1] < a[i]) hi = i;
+        else lo = i + 1;
+    }
+    return lo;
+}
+
+}
+
+void parallel_sort(vector<XYItem> &items, int threads) {
+    size_t n = items.size();
+    size_t count = threads > 0 ? threads : max(1u, std::thread::hardware_concurrency());
+    count = min(count, n / 65536 + 1);
+
+    vector<size_t> bounds;
+    for(size_t i = 0; i <= count; i++) {
+        bounds.push_back(n / count * i + min(i, n % count));
+    }
+    vector<std::thread> workers;
+    for(size_t i = 1; i < count; i++) {
+        workers.push_back(std::thread([&items, &bounds, i]() {
+            stable_sort(items.begin() + bounds[i], items.begin() + bounds[i+1]);
+        }));
+    }
+    stable_sort(items.begin(), items.begin() + bounds[1]);
+    for(std::thread &t : workers) t.join();
+    if(count == 1) return;
+
+    vector<XYItem> buffer(n, XYItem(0, 0));
+    XYItem *src = items.data();
+    XYItem *dst = buffer.data();
+    while(bounds.size() > 2) {
+        size_t pairs = (bounds.size() - 1) / 2;
+        size_t parts = max<size_t>(1, count / pairs);
+        vector<size_t> next;
+        workers.clear();
+        for(size_t p = 0; p + 1 < bounds.size(); p += 2) {
+            size_t lo = bounds[p];
+            size_t mid = bounds[p+1];
+            size_t hi = p + 2 < bounds.size() ? bounds[p+2] : mid;
+            next.push_back(lo);
+            const XYItem *a = src + lo;
+            const XYItem *b = src + mid;
+            size_t m = mid - lo;
+            size_t r = hi - mid;
+            for(size_t s = 0; s < parts; s++) {
+                size_t k0 = (m + r) * s / parts;
+                size_t k1 = (m + r) * (s + 1) / parts;
+                workers.push_back(std::thread([=]() {
+                    size_t i0 = corank(k0, a, m, b, r);
+                    size_t i1 = corank(k1, a, m, b, r);
+                    std::merge(a + i0, a + i1, b + (k0 - i0), b + (k1 - i1), dst + lo + k0);
+                }));
+            }
+        }
+        next.push_back(n);
+        for(std::thread &t : workers) t.join();
+        swap(src, dst);
+        bounds.swap(next);
+    }
+    if(src != items.data()) items.swap(buffer);
+}
+
+size_t unique_x(vector<XYItem> &items) {
+    size_t before = items.size();
+    items.erase(unique(items.begin(), items.end(), [](const XYItem &a, const XYItem &b) {
+        return a.x() == b.x();
+    }), items.end());
+    return before - items.size();
+}
@@ -0,0 +1,15 @@
+#ifndef PARALLELSORT_H
+#define PARALLELSORT_H
+
+#include "series.h"
+
+// Stable sort of samples by x. Every thread sorts one slice, then the
+// slices are merged pairwise, each merge split across the threads by
+// binary searching where its output is cut. threads 0 picks one per core.
+void parallel_sort(vector<XYItem> &items, int threads = 0);
+
+// Drops every sample whose x equals the one before it, so on a stably
+// sorted vector the first sample added wins. Returns how many were dropped.
+size_t unique_x(vector<XYItem> &items);
+
+#endif // PARALLELSORT_H
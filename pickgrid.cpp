@@ -0,0 +1,66 @@
+#include "pickgrid.h"
+
+bool PickGrid::isValid(Axis *domain, Axis *range, QRectF area) const {
+    Range d = domain->getRange();
+    Range r = range->getRange();
+    return columns > 0 && this->area == area
+            && domain_min == d.min() && domain_max == d.max()
+            && range_min == r.min() && range_max == r.max()
+            && domain_invert == domain->isInvert() && range_invert == range->isInvert();
+}
+
+bool PickGrid::canExtend(XYSeries *series) const {
+    return count <= series->getCount() && series->getAppendedCount() - appended == series->getCount() - count;
+}
+
+void PickGrid::build(XYSeries *series, Axis *domain, Pos domain_pos, Axis *range, Pos range_pos, QRectF area) {
+    count = 0;
+    this->area = area;
+    domain_min = domain->getRange().min();
+    domain_max = domain->getRange().max();
+    range_min = range->getRange().min();
+    range_max = range->getRange().max();
+    domain_invert = domain->isInvert();
+    range_invert = range->isInvert();
+    columns = (int)ceil(area.width() / CELL) + 1;
+    rows = (int)ceil(area.height() / CELL) + 1;
+    cells.assign((size_t)columns * rows, vector<Entry>());
+    extend(series, domain, domain_pos, range, range_pos);
+}
+
+void PickGrid::extend(XYSeries *series, Axis *domain, Pos domain_pos, Axis *range, Pos range_pos) {
+    size_t last = series->getCount();
+    for(size_t i = count; i < last; i++) {
+        XYItem item = series->getItem(i);
+        QPointF p(domain->value_to_point(item.x(), area, domain_pos), range->value_to_point(item.y(), area, range_pos));
+        if(!area.contains(p)) continue;
+        int cell = (int)((p.y() - area.y()) / CELL) * columns + (int)((p.x() - area.x()) / CELL);
+        cells[cell].push_back({ p, i });
+    }
+    count = last;
+    appended = series->getAppendedCount();
+}
+
+bool PickGrid::find(QPointF point, qreal &distance, size_t &index, QPointF &found) const {
+    if(columns == 0) return false;
+    int c0 = max(0, (int)floor((point.x() - distance - area.x()) / CELL));
+    int c1 = min(columns - 1, (int)floor((point.x() + distance - area.x()) / CELL));
+    int r0 = max(0, (int)floor((point.y() - distance - area.y()) / CELL));
+    int r1 = min(rows - 1, (int)floor((point.y() + distance - area.y()) / CELL));
+    bool hit = false;
+    for(int r = r0; r <= r1; r++) {
+        for(int c = c0; c <= c1; c++) {
+            for(const Entry &entry : cells[(size_t)r * columns + c]) {
+                QPointF d = entry.point - point;
+                qreal dist = sqrt(d.x() * d.x() + d.y() * d.y());
+                if(dist < distance) {
+                    distance = dist;
+                    index = entry.index;
+                    found = entry.point;
+                    hit = true;
+                }
+            }
+        }
+    }
+    return hit;
+}
@@ -0,0 +1,66 @@
+#ifndef PICKGRID_H
+#define PICKGRID_H
+
+#include <QRectF>
+
+#include "axis.h"
+#include "series.h"
+
+// Nearest sample found by XYRender::pick().
+class PickResult {
+public:
+    XYSeries *series;
+    size_t index;
+    XYItem item;
+    QPointF point;
+    qreal distance;
+
+public:
+    PickResult() : series(nullptr), index(0), item(0, 0), distance(0) {}
+};
+
+// Uniform grid of CELL pixel cells over the chart area, holding the screen
+// position of every visible sample of an unsorted series. It is built for
+// one view, takes in samples appended since then, and answers
+// nearest-sample queries by looking only at the cells within the search
+// radius.
+class PickGrid {
+public:
+    constexpr static int CELL = 16;
+
+private:
+    class Entry {
+    public:
+        QPointF point;
+        size_t index;
+    };
+
+    size_t count;
+    quint64 appended;
+    QRectF area;
+    qreal domain_min;
+    qreal domain_max;
+    qreal range_min;
+    qreal range_max;
+    bool domain_invert;
+    bool range_invert;
+    int columns;
+    int rows;
+    vector<vector<Entry>> cells;
+
+public:
+    PickGrid() : count(0), appended(0), domain_min(0), domain_max(0), range_min(0), range_max(0), domain_invert(false), range_invert(false), columns(0), rows(0) {}
+    // Whether the grid was built for this view.
+    bool isValid(Axis *domain, Axis *range, QRectF area) const;
+    // Whether the series only had samples appended since the grid last saw
+    // it, so extend() can catch up; otherwise indices moved and the grid
+    // has to be built again.
+    bool canExtend(XYSeries *series) const;
+    void build(XYSeries *series, Axis *domain, Pos domain_pos, Axis *range, Pos range_pos, QRectF area);
+    void extend(XYSeries *series, Axis *domain, Pos domain_pos, Axis *range, Pos range_pos);
+    // Looks for a sample closer than distance to point; on success distance,
+    // index and found are updated.
+    bool find(QPointF point, qreal &distance, size_t &index, QPointF &found) const;
+};
+
+#endif // PICKGRID_H
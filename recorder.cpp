@@ -0,0 +1,205 @@
+#include "recorder.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstring>
+
+using namespace std::chrono;
+
+static_assert(sizeof(XYItem) == 2 * sizeof(double), "XYItem must be a plain x/y pair");
+
+SeriesRecorder::SeriesRecorder(XYSeries *series, QString path, size_t queue_limit, int sync_interval) :
+    series(series),
+    path(path),
+    queue_limit(queue_limit),
+    sync_interval(sync_interval),
+    stopping(false),
+    block(RECORD_BLOCK),
+    block_count(0),
+    block_seq(0),
+    offset(0),
+    failed(false)
+{
+    if(!series) throw 1;
+    fd = ::open(path.toLocal8Bit().constData(), O_CREAT | O_TRUNC | O_WRONLY, 0644);
+    if(fd < 0) throw 1;
+    writer = std::thread(&SeriesRecorder::run, this);
+    series->addSeriesAppendListener(this);
+}
+
+SeriesRecorder::~SeriesRecorder()
+{
+    series->removeSeriesAppendListener(this);
+    {
+        std::lock_guard<std::mutex> l(lock);
+        stopping = true;
+    }
+    wake.notify_all();
+    writer.join();
+    ::close(fd);
+}
+
+RecorderStats SeriesRecorder::getStats() const {
+    std::lock_guard<std::mutex> l(lock);
+    return stats;
+}
+
+void SeriesRecorder::onSeriesAppended(const SeriesAppendEvent *event) {
+    std::unique_lock<std::mutex> l(lock);
+    if(pending.size() * sizeof(XYItem) >= queue_limit) {
+        steady_clock::time_point start = steady_clock::now();
+        stats.stalls++;
+        space.wait(l, [&]() {
+            return pending.size() * sizeof(XYItem) < queue_limit;
+        });
+        stats.stall_ns += duration_cast<nanoseconds>(steady_clock::now() - start).count();
+    }
+    pending.insert(pending.end(), event->items, event->items + event->count);
+    stats.samples_queued += event->count;
+    stats.queue_bytes = pending.size() * sizeof(XYItem);
+    stats.queue_peak_bytes = max(stats.queue_peak_bytes, stats.queue_bytes);
+    if(pending.size() >= RECORD_BLOCK_SAMPLES) {
+        l.unlock();
+        wake.notify_one();
+    }
+}
+
+void SeriesRecorder::run() {
+    vector<XYItem> items;
+    bool dirty = false;
+    steady_clock::time_point deadline = steady_clock::now() + milliseconds(sync_interval);
+    std::unique_lock<std::mutex> l(lock);
+    for(;;) {
+        wake.wait_until(l, deadline, [&]() {
+            return stopping || pending.size() >= RECORD_BLOCK_SAMPLES;
+        });
+        bool stop = stopping;
+        items.swap(pending);
+        stats.queue_bytes = 0;
+        l.unlock();
+        space.notify_all();
+
+        if(!items.empty()) dirty = true;
+        write(items);
+        items.clear();
+        bool due = steady_clock::now() >= deadline;
+        if(dirty && (due || stop)) {
+            sync();
+            dirty = false;
+        }
+        if(due) {
+            deadline = steady_clock::now() + milliseconds(sync_interval);
+        }
+
+        l.lock();
+        if(stop) return;
+    }
+}
+
+void SeriesRecorder::write(const vector<XYItem> &items) {
+    size_t i = 0;
+    while(!failed && i < items.size()) {
+        size_t n = min(items.size() - i, RECORD_BLOCK_SAMPLES - block_count);
+        memcpy(block.data() + sizeof(RecordBlockHeader) + block_count * sizeof(XYItem), &items[i], n * sizeof(XYItem));
+        block_count += n;
+        i += n;
+        if(block_count == RECORD_BLOCK_SAMPLES) writeBlock();
+    }
+    std::lock_guard<std::mutex> l(lock);
+    if(!failed) stats.samples_written += items.size();
+}
+
+// Appends the samples collected so far as one record and starts the next.
+void SeriesRecorder::writeBlock() {
+    RecordBlockHeader header;
+    header.magic = RECORD_MAGIC;
+    header.count = block_count;
+    header.seq = block_seq;
+    header.checksum = record_checksum(block.data() + sizeof(header), block_count * sizeof(XYItem));
+    header.reserved = 0;
+    memcpy(block.data(), &header, sizeof(header));
+
+    size_t size = sizeof(header) + block_count * sizeof(XYItem);
+    size_t left = size;
+    const char *p = block.data();
+    off_t at = offset;
+    while(left > 0) {
+        ssize_t n = pwrite(fd, p, left, at);
+        if(n <= 0) {
+            qWarning() << "recorder: write failed " << path;
+            std::lock_guard<std::mutex> l(lock);
+            stats.write_errors++;
+            stats.failed = failed = true;
+            return;
+        }
+        p += n;
+        left -= n;
+        at += n;
+    }
+    offset += size;
+    block_seq++;
+    block_count = 0;
+    std::lock_guard<std::mutex> l(lock);
+    stats.bytes_written += size;
+}
+
+void SeriesRecorder::sync() {
+    if(failed) return;
+    if(block_count > 0) writeBlock();
+    if(failed) return;
+    steady_clock::time_point start = steady_clock::now();
+    int result = fdatasync(fd);
+    quint64 ns = duration_cast<nanoseconds>(steady_clock::now() - start).count();
+    std::lock_guard<std::mutex> l(lock);
+    stats.syncs++;
+    stats.sync_max_ns = max(stats.sync_max_ns, ns);
+    if(result < 0) {
+        qWarning() << "recorder: sync failed " << path;
+        stats.sync_errors++;
+        stats.failed = failed = true;
+    }
+}
+
+size_t SeriesRecorder::replay(QString path, XYSeries *series, bool notify) {
+    int fd = ::open(path.toLocal8Bit().constData(), O_RDONLY);
+    if(fd < 0) throw 1;
+    struct stat st;
+    if(fstat(fd, &st) < 0) {
+        ::close(fd);
+        throw 1;
+    }
+    size_t length = st.st_size;
+    if(length < sizeof(RecordBlockHeader)) {
+        ::close(fd);
+        return 0;
+    }
+    void *base = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if(base == MAP_FAILED) throw 1;
+    madvise(base, length, MADV_SEQUENTIAL);
+
+    const char *data = static_cast<const char*>(base);
+    vector<XYItem> items;
+    items.reserve(length / sizeof(XYItem));
+    size_t offset = 0;
+    for(uint64_t seq = 0; length - offset >= sizeof(RecordBlockHeader); seq++) {
+        const char *p = data + offset;
+        RecordBlockHeader header;
+        memcpy(&header, p, sizeof(header));
+        if(header.magic != RECORD_MAGIC || header.seq != seq || header.count > RECORD_BLOCK_SAMPLES) break;
+        size_t size = sizeof(header) + header.count * sizeof(XYItem);
+        if(length - offset < size) break;
+        const char *payload = p + sizeof(header);
+        if(record_checksum(payload, header.count * sizeof(XYItem)) != header.checksum) break;
+        const XYItem *first = reinterpret_cast<const XYItem*>(payload);
+        items.insert(items.end(), first, first + header.count);
+        offset += size;
+    }
+    munmap(base, length);
+    series->addAll(items, notify);
+    return items.size();
+}
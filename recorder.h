@@ -0,0 +1,88 @@
+#ifndef RECORDER_H
+#define RECORDER_H
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "series.h"
+#include "recordfile.h"
+
+class RecorderStats {
+public:
+    quint64 samples_queued;
+    quint64 samples_written;
+    quint64 bytes_written;
+    quint64 queue_bytes;
+    quint64 queue_peak_bytes;
+    quint64 stalls;
+    quint64 stall_ns;
+    quint64 syncs;
+    quint64 sync_max_ns;
+    quint64 write_errors;
+    quint64 sync_errors;
+    bool failed;
+
+public:
+    RecorderStats() : samples_queued(0), samples_written(0), bytes_written(0), queue_bytes(0), queue_peak_bytes(0),
+        stalls(0), stall_ns(0), syncs(0), sync_max_ns(0), write_errors(0), sync_errors(0), failed(false) {}
+};
+
+// Persists every sample appended to a series (see recordfile.h). Appends
+// only copy the batch into a queue; a writer thread packs it into records
+// appended to the file and fdatasync()s every sync interval. If the writer
+// falls more than the queue limit behind, appends wait for it rather than
+// drop samples; the waits show up in getStats() as stalls.
+//
+// A failed write or sync leaves the end of the file in doubt, so the
+// recorder counts it, turns failed and stops writing; queued samples are
+// then discarded and no longer count as written.
+//
+// The recorder must be destroyed before its series; destruction flushes
+// and syncs everything queued.
+class SeriesRecorder : public SeriesAppendListener {
+private:
+    XYSeries *series;
+    QString path;
+    int fd;
+    size_t queue_limit;
+    int sync_interval;
+
+    std::thread writer;
+    mutable std::mutex lock;
+    std::condition_variable wake;
+    std::condition_variable space;
+    vector<XYItem> pending;
+    bool stopping;
+    RecorderStats stats;
+
+    vector<char> block;
+    size_t block_count;
+    quint64 block_seq;
+    off_t offset;
+    bool failed;
+
+    void run();
+    void write(const vector<XYItem> &items);
+    void writeBlock();
+    void sync();
+
+public:
+    SeriesRecorder(XYSeries *series, QString path, size_t queue_limit = 64 << 20, int sync_interval = 1000);
+    ~SeriesRecorder();
+
+    QString getPath() const {
+        return path;
+    }
+    RecorderStats getStats() const;
+    bool isFailed() const {
+        return getStats().failed;
+    }
+    void onSeriesAppended(const SeriesAppendEvent *event);
+
+    // Appends every sample of a recording to series in one batch and
+    // returns how many there were. Stops at the first torn record.
+    static size_t replay(QString path, XYSeries *series, bool notify = true);
+};
+
+#endif // RECORDER_H
@@ -0,0 +1,44 @@
+#ifndef RECORDFILE_H
+#define RECORDFILE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Sample recording written by SeriesRecorder, native endian. The file is a
+// sequence of records:
+//
+//   RecordBlockHeader (32 bytes)
+//   double x, y pairs, count of them
+//
+// A record holds at most RECORD_BLOCK_SAMPLES samples, so at most
+// RECORD_BLOCK bytes, and every sync appends one for whatever was written
+// since the last; records are never rewritten, so a crash can't damage
+// samples that were already synced. seq numbers records from 0. checksum is
+// FNV-1a over the pairs, so a record torn by a crash is detected and replay
+// stops in front of it.
+
+const uint32_t RECORD_MAGIC = 0x52595853;
+const size_t RECORD_BLOCK = 1 << 16;
+
+struct RecordBlockHeader {
+    uint32_t magic;
+    uint32_t count;
+    uint64_t seq;
+    uint64_t checksum;
+    uint64_t reserved;
+};
+
+static_assert(sizeof(RecordBlockHeader) == 32, "RecordBlockHeader layout changed");
+
+const size_t RECORD_BLOCK_SAMPLES = (RECORD_BLOCK - sizeof(RecordBlockHeader)) / (2 * sizeof(double));
+
+inline uint64_t record_checksum(const void *data, size_t size) {
+    const uint64_t *p = static_cast<const uint64_t*>(data);
+    uint64_t h = 14695981039346656037ULL;
+    for(size_t i = 0; i < size / sizeof(uint64_t); i++) {
+        h = (h ^ p[i]) * 1099511628211ULL;
+    }
+    return h;
+}
+
+#endif // RECORDFILE_H
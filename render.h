@@ -4,18 +4,32 @@
 #include <QtDebug>
 #include <QWidget>
 #include <QPainter>
+#include <QImage>
+#include <QElapsedTimer>
 
 #include "axis.h"
 #include "series.h"
+#include "pickgrid.h"
+#include "densitygrid.h"
+#include "barcache.h"
+#include "frameprofiler.h"
+#include "renderstats.h"
+
+#include <map>
+#include <climits>
 
 class XYRender;
 
+// overlay is set when only interaction overlays (rubber band, crosshair)
+// moved; rects then holds the screen rects that need repainting.
 class RenderChangeEvent {
 public:
     XYRender *render;
+    bool overlay;
+    QVector<QRect> rects;
 
 public:
-    RenderChangeEvent(XYRender *_render) : render(_render) {
+    RenderChangeEvent(XYRender *_render, bool _overlay = false) : render(_render), overlay(_overlay) {
 
     }
 };
@@ -25,21 +39,153 @@ public:
     virtual void onRenderChanged(const RenderChangeEvent* event) = 0;
 };
 
+// A view the chart was zoomed away from, with the series layer it was last
+// drawn with when that is still around.
+class ZoomLevel {
+public:
+    Range domain;
+    Range range;
+    bool zoom;
+    QImage frame;
+    QRect bounds;
+    qreal ratio;
+    size_t revision;
+
+public:
+    ZoomLevel(Range _domain, Range _range, bool _zoom) : domain(_domain), range(_range), zoom(_zoom), ratio(1), revision(0) {}
+    size_t getFrameBytes() const {
+        return frame.isNull() ? 0 : (size_t)frame.width() * frame.height() * 4;
+    }
+};
+
+// What drawSeries() draws of a series in a window: the visible index range
+// and how it gets reduced.
+class SeriesPlan {
+public:
+    size_t first;
+    size_t last;
+    int level;
+    bool decimated;
+
+public:
+    SeriesPlan() : first(0), last(0), level(-1), decimated(false) {}
+};
+
+// Receives the series of a chart reduced for vector output, a chunk at a
+// time; see XYRender::exportSeries(). Consecutive line chunks of a series
+// share their end points, so they join up.
+class SeriesSink {
+public:
+    virtual ~SeriesSink() {}
+    virtual void beginSeries(XYSeries *series, QColor color, QRectF clip) = 0;
+    virtual void addLine(const QPointF *points, int count) = 0;
+    virtual void addMarks(const QPointF *points, int count) = 0;
+    // A series drawn as pixels, like a density map, covering rect.
+    virtual void addImage(QRectF rect, const QImage &image) = 0;
+    virtual void endSeries() {}
+};
+
+// How a series is drawn. PLOT follows the render's line and marker
+// switches. DENSITY draws the per pixel sample count through the render's
+// colormap. CANDLES and BAND draw open/high/low/close per time bucket, as
+// candlesticks or as a min/max band around the closes.
 class SeriesHolder {
 public:
+    enum Style { PLOT, DENSITY, CANDLES, BAND };
+
     XYSeries *series;
     QColor color;
+    Style style;
 
 public:
-    SeriesHolder(XYSeries *_series = nullptr, QColor _color = Qt::red) : series(_series), color(_color) {}
+    SeriesHolder(XYSeries *_series = nullptr, QColor _color = Qt::red) : series(_series), color(_color), style(PLOT) {}
+    bool isBars() const {
+        return style == CANDLES || style == BAND;
+    }
 };
 
-class XYRender : public SeriesChangeListener, AxisChangeListener{
+class DecimateColumn {
+public:
+    int index;
+    qreal first_y;
+    qreal min_y;
+    qreal max_y;
+    qreal last_y;
+    bool empty;
+
+public:
+    DecimateColumn() : index(0), first_y(0), min_y(0), max_y(0), last_y(0), empty(true) {}
+    void add(int _index, qreal first, qreal lo, qreal hi, qreal last) {
+        if(empty) {
+            index = _index;
+            first_y = first;
+            min_y = lo;
+            max_y = hi;
+            empty = false;
+        } else {
+            if(lo < min_y) min_y = lo;
+            if(hi > max_y) max_y = hi;
+        }
+        last_y = last;
+    }
+};
+
+// Consecutive line points of an unsorted series within one pixel column,
+// reduced to the first, lowest, highest and last of them in their order.
+class ScatterRun {
+public:
+    int index;
+    int count;
+    QPointF first;
+    QPointF lo;
+    QPointF hi;
+    QPointF last;
+    int lo_at;
+    int hi_at;
+
+public:
+    ScatterRun() : index(0), count(0), lo_at(0), hi_at(0) {}
+    void add(int _index, QPointF p) {
+        if(count == 0) {
+            index = _index;
+            first = lo = hi = p;
+        } else if(p.y() < lo.y()) {
+            lo = p;
+            lo_at = count;
+        } else if(p.y() > hi.y()) {
+            hi = p;
+            hi_at = count;
+        }
+        last = p;
+        count++;
+    }
+    void flush(QVector<QPointF> &out) {
+        QPointF points[4] = { first, lo_at < hi_at ? lo : hi, lo_at < hi_at ? hi : lo, last };
+        for(int i = 0; i < 4; i++) {
+            if(i > 0 && points[i] == points[i-1]) continue;
+            out.append(points[i]);
+        }
+        count = 0;
+        lo_at = hi_at = 0;
+    }
+};
+
+class XYRender : public SeriesChangeListener, SeriesAppendListener, AxisChangeListener{
 public:
     constexpr static qreal TICK_HEIGHT = 5;
     constexpr static qreal GAP = 8;
     constexpr static qreal TICK_DIV = 10;
     constexpr static qreal TICK_THICKNESS = 2;
+    constexpr static qreal DECIMATE_THRESHOLD = 4;
+    constexpr static int ZOOM_HISTORY = 32;
+    constexpr static size_t SLICE = 1 << 16;
+    constexpr static qreal LINE_WIDTH = 1.5;
+    constexpr static qreal MARK_RADIUS = 3;
+    constexpr static int EXPORT_CHUNK = 4096;
+    constexpr static size_t DENSITY_DRAFT_SAMPLES = 1 << 20;
+    constexpr static qreal CANDLE_WIDTH = 6;
+    constexpr static qreal CANDLE_BODY = 0.7;
+    constexpr static int BAND_ALPHA = 96;
 
 private:
 
@@ -49,6 +195,8 @@ private:
     bool touch;
     bool zoom;
     bool grid;
+    bool crosshair;
+    bool crosshair_visible;
 
     int mouse;
 
@@ -56,6 +204,7 @@ private:
     Pos range_pos;
     QPoint start_point;
     QPoint end_point;
+    QPoint crosshair_point;
     QRectF area;
     QMarginsF margins;
     QColor title_color;
@@ -74,6 +223,51 @@ private:
 
     QVector<SeriesHolder> series_list;
     QVector<RenderChangeListener*> listeners;
+    map<XYSeries*, PickGrid> pick_grids;
+    map<XYSeries*, DensityGrid> density_grids;
+    DensityColormap density_colormap;
+    int density_threads;
+    map<XYSeries*, BarCache> bar_caches;
+
+    // A QImage rather than a QPixmap so a render can paint off the GUI
+    // thread, one render per thread.
+    QImage series_layer;
+    bool layer_valid;
+    QRect layer_bounds;
+    QPointF layer_origin;
+    Range layer_domain;
+    Range layer_range;
+    qreal layer_ratio;
+    size_t revision;
+
+    vector<ZoomLevel> zoom_history;
+    size_t zoom_cache_limit;
+
+    int frame_budget;
+    int idle_delay;
+    int draft_column;
+    int column_width;
+    bool draft;
+    bool layer_draft;
+    bool interacting;
+    bool refining;
+    qint64 frame_time;
+    QElapsedTimer frame_timer;
+
+    bool progressive;
+    bool sliced;
+    bool layer_complete;
+    QRectF layer_window;
+    int progress_series;
+    size_t progress_index;
+    bool progress_planned;
+    SeriesPlan progress_plan;
+
+    FrameProfiler profiler;
+    bool profile_hud;
+    RenderStats stats;
+    bool chrome_only;
+    QRectF content_window;
 
     Axis* domain;
     Axis* range;
@@ -114,6 +308,8 @@ public:
         touch(false),
         zoom(false),
         grid(true),
+        crosshair(false),
+        crosshair_visible(false),
         margins(10, 10, 10, 10),
         title_color(Qt::black),
         axis_text_color(Qt::black),
@@ -122,6 +318,30 @@ public:
         tick_text_color(Qt::black),
         chart_color(Qt::white),
         bg_color(Qt::lightGray),
+        density_threads(0),
+        layer_valid(false),
+        layer_domain(0, 1),
+        layer_range(0, 1),
+        layer_ratio(1),
+        revision(0),
+        zoom_cache_limit(64 << 20),
+        frame_budget(16),
+        idle_delay(150),
+        draft_column(2),
+        column_width(1),
+        draft(false),
+        layer_draft(false),
+        interacting(false),
+        refining(false),
+        frame_time(0),
+        progressive(false),
+        sliced(false),
+        layer_complete(false),
+        progress_series(0),
+        progress_index(0),
+        progress_planned(false),
+        profile_hud(false),
+        chrome_only(false),
         domain(0),
         range(0)
     {
@@ -137,8 +357,11 @@ public:
             range->removeAxisChangeListener(this);
             delete range;
         }
-        for(SeriesHolder &holder : series_list) {
+        // Last added first, so derived series go before their sources.
+        for(int i = series_list.size() - 1; i >= 0; i--) {
+            SeriesHolder &holder = series_list[i];
             holder.series->removeSeriesChangeListener(this);
+            if(holder.style != SeriesHolder::PLOT) holder.series->removeSeriesAppendListener(this);
             delete holder.series;
         }
         qDebug() << "render destroy";
@@ -161,8 +384,12 @@ public:
         if(!series) throw 1;
         int idx = indexOf(series);
         if(idx == -1) return;
+        if(series_list[idx].style != SeriesHolder::PLOT) series->removeSeriesAppendListener(this);
         series_list.remove(idx);
         series->removeSeriesChangeListener(this);
+        pick_grids.erase(series);
+        density_grids.erase(series);
+        bar_caches.erase(series);
         fire();
     }
     bool contains(XYSeries *series) const {
@@ -192,6 +419,44 @@ public:
     QColor getSeriesColor(int series) const {
         return series_list[series].color;
     }
+    // DENSITY is meant for scatter series too large to draw point by
+    // point. Its counts are kept between frames; as long as the axes don't
+    // move, a frame only bins the samples appended since the last one.
+    // CANDLES and BAND are meant for tick data and need a sorted series;
+    // see BarCache for what they keep.
+    void setSeriesStyle(int series, SeriesHolder::Style style, bool notify = true) {
+        SeriesHolder &holder = series_list[series];
+        if(holder.style == style) return;
+        if((style == SeriesHolder::CANDLES || style == SeriesHolder::BAND) && !holder.series->isSorted()) throw 1;
+        if(holder.style == SeriesHolder::PLOT) holder.series->addSeriesAppendListener(this);
+        if(style == SeriesHolder::PLOT) holder.series->removeSeriesAppendListener(this);
+        holder.style = style;
+        if(style != SeriesHolder::DENSITY) density_grids.erase(holder.series);
+        if(!holder.isBars()) bar_caches.erase(holder.series);
+        if(notify) fire();
+    }
+    SeriesHolder::Style getSeriesStyle(int series) const {
+        return series_list[series].style;
+    }
+    void setDensityColormap(const DensityColormap &colormap, bool notify = true) {
+        density_colormap = colormap;
+        for(auto &entry : density_grids) {
+            entry.second.invalidateImage();
+        }
+        if(notify) fire();
+    }
+    const DensityColormap& getDensityColormap() const {
+        return density_colormap;
+    }
+    // Threads a density scan may spread over; 0 means one per core. Renders
+    // that already run one per core, like the batch renderer's, want 1.
+    void setDensityThreads(int threads) {
+        if(threads < 0) throw 1;
+        density_threads = threads;
+    }
+    int getDensityThreads() const {
+        return density_threads;
+    }
     void setTitleColor(QColor color, bool notify = true) {
         set_value(title_color, color, notify);
     }
@@ -270,6 +535,12 @@ public:
     bool isDrawGrid() const {
         return grid;
     }
+    void setDrawCrosshair(bool crosshair, bool notify = true) {
+        set_value(this->crosshair, crosshair, notify);
+    }
+    bool isDrawCrosshair() const {
+        return crosshair;
+    }
     void setTitle(QString title, bool notify = true) {
         set_value(this->title, title, notify);
     }
@@ -285,19 +556,95 @@ public:
     QMarginsF getMargins() const {
         return margins;
     }
+    // The plot area as laid out by the last paint.
+    QRectF getArea() const {
+        return area;
+    }
     void paint(QPainter *g, QWidget* widget) {
+        paint(g, widget->size());
+    }
+    // Paints at size in device independent pixels, on any paint device;
+    // see toImage() for rendering without a widget.
+    void paint(QPainter *g, QSize size) {
+        paintContent(g, size);
+        paintOverlay(g);
+    }
+    QImage toImage(QSize size, qreal ratio = 1) {
+        QImage image(size * ratio, QImage::Format_ARGB32_Premultiplied);
+        image.setDevicePixelRatio(ratio);
+        QPainter g(&image);
+        paint(&g, size);
+        return image;
+    }
+    // Vector output (SVG, PDF; see vectorexport.h) can't go through the
+    // raster series layer. paintChrome() lays the chart out at full
+    // quality and draws everything but the series; exportSeries() then
+    // hands them to a sink reduced to one pixel column of that layout, in
+    // chunks of at most chunk points. What it emits follows the output
+    // size, not the sample count: sorted series are decimated like on
+    // screen, unsorted ones keep one marker per pixel, only the line
+    // segments crossing the plot, and of consecutive line points in one
+    // pixel column the first, lowest, highest and last. Density, candle
+    // and band series are handed over as an image of the plot.
+    void paintChrome(QPainter *g, QSize size) {
+        chrome_only = true;
+        refining = true;
+        paintContent(g, size);
+        chrome_only = false;
+    }
+    void exportSeries(SeriesSink *sink, int chunk = EXPORT_CHUNK) {
+        if(chunk < 2) throw 1;
+        int saved = column_width;
+        column_width = 1;
+        for(SeriesHolder &holder : series_list) {
+            sink->beginSeries(holder.series, holder.color, content_window);
+            if(holder.style != SeriesHolder::PLOT) {
+                exportImage(sink, holder);
+            } else if(holder.series->isSorted()) {
+                exportSorted(sink, holder.series, chunk);
+            } else {
+                exportScattered(sink, holder.series, chunk);
+            }
+            sink->endSeries();
+        }
+        column_width = saved;
+    }
+    // Everything but the interaction overlays, so a view can cache it and
+    // repaint only what an overlay covered.
+    // With sliced set and progressive rendering on, the series layer may be
+    // left incomplete once the frame budget is spent; see isComplete().
+    void paintContent(QPainter *g, QWidget* widget, bool sliced = false) {
+        paintContent(g, widget->size(), sliced);
+    }
+    void paintContent(QPainter *g, QSize size, bool sliced = false) {
+        frame_timer.start();
+        stats.resetFrame();
+        stats.frames++;
+        this->sliced = sliced;
+        draft = frame_budget > 0 && !refining && ((touch && gesture) || interacting || frame_time > frame_budget);
+        refining = false;
+        column_width = draft ? draft_column : 1;
+        {
+            ProfileScope scope(profiler, FrameProfiler::FRAME);
+            syncPending();
+            drawContent(g, size);
+        }
+        frame_time = frame_timer.elapsed();
+    }
+    void drawContent(QPainter *g, QSize size) {
         int x = 0;
         int y = 0;
-        int width = widget->width();
-        int height = widget->height();
+        int width = size.width();
+        int height = size.height();
 
-        g->setRenderHint(QPainter::Antialiasing);
+        g->setRenderHint(QPainter::Antialiasing, !draft);
         g->setPen(Qt::black);
         g->setBrush(bg_color);
         g->drawRect(x, y, width, height);
 
         if(width < 2 || height < 2) return;
 
+        auto layout_start = profiler.begin();
         bool has_title = !title.isEmpty();
         bool has_top = hasPos(TOP);
         bool has_bottom = hasPos(BOTTOM);
@@ -349,6 +696,7 @@ public:
             chart_h -= title_height;
         }
 
+        profiler.end(FrameProfiler::LAYOUT, layout_start);
         if(chart_w < 2 || chart_h < 2) return;
 
         area.setRect(chart_x, chart_y, chart_w, chart_h);
@@ -358,6 +706,14 @@ public:
 
         Axis* arr[] = { domain, range };
 
+        {
+            ProfileScope scope(profiler, FrameProfiler::AUTO_RANGE);
+            for(Axis* axis : arr) {
+                updateAxisRange(axis, 1.05);
+            }
+        }
+
+        auto axes_start = profiler.begin();
         g->setClipRect(x, y, width, height);
         for(Axis* axis : arr) {
             Pos pos = getPos(axis);
@@ -396,20 +752,36 @@ public:
                 break;
             default: throw 1;
             }
-            updateAxisRange(axis, 1.05);
             drawAxis(g, axis, pos, axis_x, axis_y, axis_w, axis_h);
         }
+        profiler.end(FrameProfiler::AXES, axes_start);
 
+        auto series_start = profiler.begin();
         chart_window -= chart_margin;
-        for(SeriesHolder &holder : series_list) {
-            drawSeries(g, holder, chart_window);
+        content_window = chart_window;
+        if(chrome_only) {
+            // exportSeries() draws them.
+        } else if(touch && gesture && mouse == Qt::MiddleButton) {
+            drawPanned(g, chart_window);
+        } else {
+            drawLayer(g, chart_window);
         }
+        profiler.end(FrameProfiler::SERIES, series_start);
 
+        if(profile_hud && profiler.isEnabled()) drawProfile(g);
+    }
+    void paintOverlay(QPainter *g) {
+        ProfileScope scope(profiler, FrameProfiler::OVERLAY);
+        if(area.isEmpty()) return;
+        g->setClipRect(area);
         if(mouse == Qt::LeftButton && gesture) {
             QPoint tl = this->start_point;
             QPoint br = this->end_point - QPoint(1, 1);
             drawGesture(g, tl, br);
         }
+        if(crosshair && crosshair_visible) {
+            drawCrosshair(g, crosshair_point);
+        }
     }
     void drawGesture(QPainter* g, QPoint tl, QPoint br) {
         g->setPen(Qt::NoPen);
@@ -418,6 +790,54 @@ public:
             g->drawRect(QRect(tl, br));
         }
     }
+    void drawProfile(QPainter* g) {
+        g->save();
+        g->setClipRect(area);
+        g->setFont(tick_text_font);
+        QFontMetrics fm = g->fontMetrics();
+        QStringList lines;
+        lines << "phase  p50  p95  p99 ms";
+        for(int phase = 0; phase < FrameProfiler::PHASES; phase++) {
+            lines << QString("%1  %2  %3  %4").arg(FrameProfiler::getPhaseName(phase))
+                     .arg(profiler.getPercentile(phase, 0.5), 0, 'f', 2)
+                     .arg(profiler.getPercentile(phase, 0.95), 0, 'f', 2)
+                     .arg(profiler.getPercentile(phase, 0.99), 0, 'f', 2);
+        }
+        int w = 0;
+        for(const QString &line : lines) {
+            w = max(w, fm.width(line));
+        }
+        QRectF box(area.x() + GAP, area.y() + GAP, w + GAP * 2, fm.height() * lines.size() + GAP * 2);
+        g->setPen(Qt::NoPen);
+        g->setBrush(QColor(0, 0, 0, 160));
+        g->drawRect(box);
+        g->setPen(Qt::white);
+        for(int i = 0; i < lines.size(); i++) {
+            g->drawText(QPointF(box.x() + GAP, box.y() + GAP + fm.ascent() + fm.height() * i), lines[i]);
+        }
+        g->restore();
+    }
+    void drawCrosshair(QPainter* g, QPoint point) {
+        g->setPen(QPen(tick_color, 1, Qt::DashLine));
+        g->drawLine(QLineF(point.x() + 0.5, area.top(), point.x() + 0.5, area.bottom()));
+        g->drawLine(QLineF(area.left(), point.y() + 0.5, area.right(), point.y() + 0.5));
+    }
+    // Moves the crosshair, hiding it outside the chart area. Only the rects
+    // of the old and the new lines are repainted.
+    void moveCrosshair(QPoint point) {
+        if(!crosshair) return;
+        QVector<QRect> rects = crosshairRects();
+        crosshair_point = point;
+        crosshair_visible = area.contains(point);
+        rects += crosshairRects();
+        if(!rects.isEmpty()) fireOverlay(rects);
+    }
+    void hideCrosshair() {
+        if(!crosshair_visible) return;
+        QVector<QRect> rects = crosshairRects();
+        crosshair_visible = false;
+        fireOverlay(rects);
+    }
     void addRenderChangeListener(RenderChangeListener* listener) {
         listeners.push_back(listener);
     }
@@ -466,11 +886,167 @@ public:
 
         return Range(min, max);
     }
+    void sync() {
+        bool changed = false;
+        for(SeriesHolder &holder : series_list) {
+            if(holder.series->sync(false)) changed = true;
+        }
+        if(changed) fire();
+    }
+    // Brings derived series up to date before they are read; their change
+    // was already notified when the source changed.
+    void syncPending() {
+        for(SeriesHolder &holder : series_list) {
+            if(holder.series->getStorage()->isPending()) holder.series->sync(false);
+        }
+    }
+    // Returns to the view before the last zoom. Its frame is reused when the
+    // data hasn't changed since, so stepping out doesn't re-render.
+    bool zoomBack() {
+        if(zoom_history.empty()) return false;
+        ZoomLevel level = zoom_history.back();
+        zoom_history.pop_back();
+        zoom = level.zoom;
+        domain->setRange(level.domain, false);
+        range->setRange(level.range, false);
+        if(!level.frame.isNull() && level.revision == revision) {
+            series_layer = level.frame;
+            layer_bounds = level.bounds;
+            layer_ratio = level.ratio;
+            layer_domain = level.domain;
+            layer_range = level.range;
+            layer_valid = true;
+            layer_complete = true;
+            layer_draft = false;
+        }
+        notify();
+        return true;
+    }
+    // Scales both axes by factor around the values under point, so what is
+    // under the cursor stays put; below 1 zooms in.
+    void zoomAt(QPointF point, qreal factor) {
+        if(!domain || !range || factor <= 0 || !area.contains(point)) return;
+        pushZoom();
+        zoom = true;
+        interacting = true;
+        qreal x = domain->point_to_value(point.x(), area, getPos(domain));
+        qreal y = range->point_to_value(point.y(), area, getPos(range));
+        Range d = domain->getRange();
+        Range r = range->getRange();
+        domain->setRange(x - (x - d.min()) * factor, x + (d.max() - x) * factor, false);
+        range->setRange(y - (y - r.min()) * factor, y + (r.max() - y) * factor, false);
+        notify();
+    }
+    // Adaptive quality: while a gesture or wheel zoom is going on, or when
+    // the last frame took longer than the budget, frames are drafts drawn
+    // without antialiasing and decimated into draft_column pixel wide
+    // columns. The view calls refine() once input has been idle for the
+    // idle delay to get the full-quality frame. A budget of 0 always draws
+    // at full quality.
+    void setFrameBudget(int msec, bool notify = true) {
+        set_value(frame_budget, msec, notify);
+    }
+    int getFrameBudget() const {
+        return frame_budget;
+    }
+    void setIdleDelay(int msec) {
+        idle_delay = msec;
+    }
+    int getIdleDelay() const {
+        return idle_delay;
+    }
+    void setDraftColumnWidth(int width, bool notify = true) {
+        if(width < 1) throw 1;
+        set_value(draft_column, width, notify);
+    }
+    int getDraftColumnWidth() const {
+        return draft_column;
+    }
+    // Counters of the last frame and of notifications; see RenderStats.
+    RenderStats getStats() const {
+        RenderStats snapshot = stats;
+        for(const SeriesHolder &holder : series_list) {
+            XYSeries *series = holder.series;
+            SeriesStats s;
+            s.name = series->getName();
+            s.count = series->getCount();
+            s.appended = series->getAppendedCount();
+            s.rejected = series->getRejectedCount();
+            s.bytes = series->getStorage()->getMemoryUsage();
+            s.fires = series->getFireCount();
+            snapshot.series.push_back(s);
+        }
+        return snapshot;
+    }
+    // Per-phase paint timings; see FrameProfiler. The HUD shows their
+    // percentiles in the corner of the chart and turns the profiler on.
+    FrameProfiler& getProfiler() {
+        return profiler;
+    }
+    void setDrawProfile(bool hud, bool notify = true) {
+        if(hud) profiler.setEnabled(true);
+        set_value(profile_hud, hud, notify);
+    }
+    bool isDrawProfile() const {
+        return profile_hud;
+    }
+    // Progressive rendering draws the series layer in slices of SLICE
+    // samples (or summary buckets) and stops once the frame budget is
+    // spent. The view keeps painting frames while !isComplete(); any change
+    // to the view or the data restarts the layer.
+    void setProgressive(bool progressive, bool notify = true) {
+        set_value(this->progressive, progressive, notify);
+    }
+    bool isProgressive() const {
+        return progressive;
+    }
+    bool isComplete() const {
+        return !layer_valid || layer_complete;
+    }
+    // Whether the last frame was a draft; its paint time in milliseconds.
+    bool isDraft() const {
+        return draft;
+    }
+    qint64 getFrameTime() const {
+        return frame_time;
+    }
+    void refine() {
+        interacting = false;
+        if(!draft) return;
+        refining = true;
+        notify();
+    }
+    int getZoomDepth() const {
+        return zoom_history.size();
+    }
+    // Bytes of cached frames the zoom history may hold; the oldest levels
+    // lose their frame first.
+    void setZoomCacheLimit(size_t bytes) {
+        zoom_cache_limit = bytes;
+        trimZoomHistory();
+    }
+    size_t getZoomCacheLimit() const {
+        return zoom_cache_limit;
+    }
+    // Fits both axes to the series again. When that is the view from before
+    // the first zoom, its cached frame is reused through zoomBack().
     void resetAllAxisRange() {
+        Range d = calc_series_bound(domain, getPos(domain));
+        Range r = calc_series_bound(range, getPos(range));
+        if(!zoom_history.empty()) {
+            const ZoomLevel &first = zoom_history.front();
+            if(!first.zoom && first.domain.min() == d.min() && first.domain.max() == d.max()
+                    && first.range.min() == r.min() && first.range.max() == r.max()) {
+                zoom_history.erase(zoom_history.begin() + 1, zoom_history.end());
+                zoomBack();
+                return;
+            }
+        }
+        zoom_history.clear();
         zoom = false;
-        domain->setRange(calc_series_bound(domain, getPos(domain)), false);
-        range->setRange(calc_series_bound(range, getPos(range)), false);
-        fire();
+        domain->setRange(d, false);
+        range->setRange(r, false);
+        notify();
     }
     void checkLimit(QPoint& point) {
         if(point.x() < area.x()) {
@@ -496,6 +1072,7 @@ public:
     }
     void updateGesture(QPoint point) {
         if(!touch) return;
+        QRect band = gestureRect();
         end_point = point;
 
         if(!gesture) {
@@ -508,7 +1085,7 @@ public:
         switch(mouse) {
         case Qt::LeftButton:
             checkLimit(end_point);
-            fire();
+            fireOverlay(QVector<QRect>() << band << gestureRect());
             break;
         case Qt::MiddleButton:
             adjustPan(start_point, end_point);
@@ -549,11 +1126,15 @@ public:
         Range r2 = range->getRange();
         domain->setRange(r1.min() - d1, r1.max() - d1, false);
         range->setRange(r2.min() - d2, r2.max() - d2, false);
-        fire();
+        // The data didn't change, so the frames kept with the zoom history
+        // stay valid; only the shifted layer is redrawn once the pan ends.
+        if(!touch) layer_valid = false;
+        notify();
     }
     void adjustAxisRange(QPoint tl, QPoint br) {
-        zoom = true;
         if(!isPositive(tl, br)) throw 1;
+        pushZoom();
+        zoom = true;
         qreal domain1 = domain->point_to_value(tl.x(), area, getPos(domain));
         qreal domain2 = domain->point_to_value(br.x(), area, getPos(domain));
         qreal range1 = range->point_to_value(tl.y(), area, getPos(range));
@@ -564,9 +1145,112 @@ public:
         qreal max_range = max(range1, range2);
         domain->setRange(min_domain, max_domain, false);
         range->setRange(min_range, max_range, false);
-        fire();
+        notify();
+    }
+    // Finds the sample drawn nearest to a point on the chart, within radius
+    // pixels, across all series. Sorted series are binary searched at the
+    // point's x; unsorted series get a screen space grid built on the first
+    // pick after the view changed, which later picks extend with appended
+    // samples.
+    bool pick(QPointF point, PickResult &result, qreal radius = 20) {
+        if(!domain || !range || area.isEmpty() || !area.contains(point)) return false;
+        result.distance = radius;
+        bool found = false;
+        for(SeriesHolder &holder : series_list) {
+            XYSeries *series = holder.series;
+            if(series->empty()) continue;
+            size_t index;
+            QPointF p;
+            bool hit;
+            if(series->isSorted()) {
+                hit = pickSorted(series, point, result.distance, index, p);
+            } else {
+                PickGrid &grid = pick_grids[series];
+                if(!grid.isValid(domain, range, area) || !grid.canExtend(series)) {
+                    grid.build(series, domain, getPos(domain), range, getPos(range), area);
+                } else {
+                    grid.extend(series, domain, getPos(domain), range, getPos(range));
+                }
+                hit = grid.find(point, result.distance, index, p);
+            }
+            if(hit) {
+                result.series = series;
+                result.index = index;
+                result.item = series->getItem(index);
+                result.point = p;
+                found = true;
+            }
+        }
+        return found;
     }
 protected:
+    QRect gestureRect() const {
+        return QRect(start_point, end_point).normalized().adjusted(-1, -1, 1, 1);
+    }
+    QVector<QRect> crosshairRects() const {
+        QVector<QRect> rects;
+        if(!crosshair_visible) return rects;
+        QRect bounds = area.toAlignedRect();
+        rects << QRect(crosshair_point.x() - 1, bounds.top(), 3, bounds.height() + 1);
+        rects << QRect(bounds.left(), crosshair_point.y() - 1, bounds.width() + 1, 3);
+        return rects;
+    }
+    // Walks a sorted series outward from the point's x until the horizontal
+    // distance alone exceeds the best match. With a storage summary whole
+    // buckets are skipped when their bounding box is too far away, so dense
+    // series only have the samples near the point looked at.
+    bool pickSorted(XYSeries *series, QPointF point, qreal &distance, size_t &index, QPointF &found) {
+        XYStorage *storage = series->getStorage();
+        Pos domain_pos = getPos(domain);
+        Pos range_pos = getPos(range);
+        size_t count = storage->size();
+        size_t center = min(storage->lowerBound(domain->point_to_value(point.x(), area, domain_pos)), count - 1);
+        size_t size = storage->getSummaryLevels() > 0 ? storage->getSummaryBucketSize(0) : 1;
+        size_t buckets = (count + size - 1) / size;
+        bool hit = false;
+        for(int dir = 0; dir < 2; dir++) {
+            size_t b = center / size;
+            if(dir == 0 && b == 0) continue;
+            if(dir == 0) b--;
+            while(b < buckets) {
+                size_t first = b * size;
+                size_t last = min(first + size, count);
+                QRectF box;
+                if(size > 1) {
+                    XYBucket bucket = storage->getSummary(0, b);
+                    box = QRectF(QPointF(domain->value_to_point(bucket.min_x, area, domain_pos), range->value_to_point(bucket.min_y, area, range_pos)),
+                                 QPointF(domain->value_to_point(bucket.max_x, area, domain_pos), range->value_to_point(bucket.max_y, area, range_pos))).normalized();
+                } else {
+                    XYItem item = storage->at(first);
+                    box = QRectF(QPointF(domain->value_to_point(item.x(), area, domain_pos), range->value_to_point(item.y(), area, range_pos)), QSizeF(0, 0));
+                }
+                qreal dx = max(max(box.left() - point.x(), point.x() - box.right()), 0.0);
+                qreal dy = max(max(box.top() - point.y(), point.y() - box.bottom()), 0.0);
+                if(dx >= distance) break;
+                if(sqrt(dx * dx + dy * dy) < distance) {
+                    for(size_t i = first; i < last; i++) {
+                        XYItem item = storage->at(i);
+                        QPointF p(domain->value_to_point(item.x(), area, domain_pos), range->value_to_point(item.y(), area, range_pos));
+                        QPointF d = p - point;
+                        qreal dist = sqrt(d.x() * d.x() + d.y() * d.y());
+                        if(dist < distance && area.contains(p)) {
+                            distance = dist;
+                            index = i;
+                            found = p;
+                            hit = true;
+                        }
+                    }
+                }
+                if(dir == 0) {
+                    if(b == 0) break;
+                    b--;
+                } else {
+                    b++;
+                }
+            }
+        }
+        return hit;
+    }
     void updateAxisRange(Axis* axis, qreal rate) {
         if(!zoom && axis->isAutoRange()) {
             Pos pos = getPos(axis);
@@ -584,49 +1268,543 @@ protected:
             axis->setRange(range, false);
         }
     }
+    // While panning, the series are drawn once into a layer that later
+    // frames shift by the pan's pixel offset, rendering only the strips
+    // scrolled into view. The full frame follows when the gesture ends.
+    void drawPanned(QPainter* g, QRectF window) {
+        QRect bounds = window.toAlignedRect();
+        qreal ratio = g->device()->devicePixelRatioF();
+        Range d = domain->getRange();
+        Range r = range->getRange();
+        QPointF origin(domain->value_to_point(layer_domain.min(), area, getPos(domain)), range->value_to_point(layer_range.min(), area, getPos(range)));
+        QPoint shift = (origin - layer_origin).toPoint();
+        bool reuse = layer_valid && layer_bounds == bounds && layer_ratio == ratio
+                && same(layer_domain.delta(), d.delta()) && same(layer_range.delta(), r.delta())
+                && abs(shift.x()) < bounds.width() && abs(shift.y()) < bounds.height();
+        if(!reuse) {
+            sliced = false;
+            renderLayer(window, bounds, ratio);
+        } else if(!shift.isNull()) {
+            QImage shifted(series_layer.size(), QImage::Format_ARGB32_Premultiplied);
+            shifted.setDevicePixelRatio(ratio);
+            shifted.fill(Qt::transparent);
+            QPainter layer(&shifted);
+            layer.setRenderHint(QPainter::Antialiasing, !draft);
+            layer.drawImage(shift, series_layer);
+            layer.translate(-bounds.topLeft());
+            QVector<QRectF> strips;
+            if(shift.x() > 0) strips << QRectF(bounds.left(), bounds.top(), shift.x(), bounds.height());
+            if(shift.x() < 0) strips << QRectF(bounds.right() + 1 + shift.x(), bounds.top(), -shift.x(), bounds.height());
+            if(shift.y() > 0) strips << QRectF(bounds.left(), bounds.top(), bounds.width(), shift.y());
+            if(shift.y() < 0) strips << QRectF(bounds.left(), bounds.bottom() + 1 + shift.y(), bounds.width(), -shift.y());
+            // Clipped to the strip, so samples culled in for the overlap don't
+            // draw over the reused pixels a second time.
+            for(const QRectF &strip : strips) {
+                layer.setClipRect(strip);
+                for(SeriesHolder &holder : series_list) {
+                    drawSeries(&layer, holder, strip);
+                }
+            }
+            layer.end();
+            series_layer = shifted;
+            layer_origin += shift;
+        }
+        g->drawImage(bounds.topLeft(), series_layer);
+    }
+    // Series are drawn through a layer keyed by the view, so coming back to
+    // a view whose frame is still cached costs a blit.
+    void drawLayer(QPainter* g, QRectF window) {
+        QRect bounds = window.toAlignedRect();
+        qreal ratio = g->device()->devicePixelRatioF();
+        if(!layer_valid || layer_draft != draft || layer_bounds != bounds || layer_ratio != ratio || !isView(layer_domain, layer_range)) {
+            renderLayer(window, bounds, ratio);
+        } else if(!layer_complete) {
+            continueLayer();
+        }
+        g->drawImage(bounds.topLeft(), series_layer);
+    }
+    void renderLayer(QRectF window, QRect bounds, qreal ratio) {
+        series_layer = QImage(bounds.size() * ratio, QImage::Format_ARGB32_Premultiplied);
+        series_layer.setDevicePixelRatio(ratio);
+        series_layer.fill(Qt::transparent);
+        layer_valid = true;
+        layer_complete = false;
+        layer_window = window;
+        progress_series = 0;
+        progress_planned = false;
+        layer_draft = draft;
+        layer_bounds = bounds;
+        layer_ratio = ratio;
+        layer_domain = domain->getRange();
+        layer_range = range->getRange();
+        layer_origin = QPointF(domain->value_to_point(layer_domain.min(), area, getPos(domain)), range->value_to_point(layer_range.min(), area, getPos(range)));
+        continueLayer();
+    }
+    // Draws the series into the layer from where the last frame stopped.
+    // Slices overlap by one sample so lines and columns join up.
+    void continueLayer() {
+        QPainter layer(&series_layer);
+        layer.setRenderHint(QPainter::Antialiasing, !layer_draft);
+        layer.translate(-layer_bounds.topLeft());
+        bool slicing = progressive && sliced && frame_budget > 0;
+        while(progress_series < series_list.size()) {
+            SeriesHolder &holder = series_list[progress_series];
+            if(holder.style != SeriesHolder::PLOT) {
+                drawSeries(&layer, holder, layer_window);
+                progress_series++;
+                if(slicing && frame_timer.elapsed() >= frame_budget) break;
+                continue;
+            }
+            if(!progress_planned) {
+                progress_plan = planSeries(holder.series, layer_window);
+                progress_index = progress_plan.first;
+                progress_planned = true;
+            }
+            size_t from = progress_index > progress_plan.first ? progress_index - 1 : progress_index;
+            size_t to = progress_plan.last;
+            if(slicing) {
+                size_t step = SLICE;
+                if(progress_plan.level >= 0) step *= holder.series->getStorage()->getSummaryBucketSize(progress_plan.level);
+                to = min(to, progress_index + step);
+            }
+            drawSeries(&layer, holder, layer_window, progress_plan, from, to);
+            progress_index = to;
+            if(progress_index >= progress_plan.last) {
+                progress_series++;
+                progress_planned = false;
+            }
+            if(slicing && frame_timer.elapsed() >= frame_budget) break;
+        }
+        layer_complete = progress_series >= series_list.size();
+    }
+    void exportSorted(SeriesSink *sink, XYSeries *series, int chunk) {
+        SeriesPlan plan = planSeries(series, content_window);
+        if(plan.first >= plan.last) return;
+        QVector<QPointF> line;
+        QVector<QPointF> marks;
+        if(plan.level >= 0 || plan.decimated) {
+            decimate(series, plan.first, plan.last, plan.level, line, marks);
+        } else {
+            Pos domain_pos = getPos(domain);
+            Pos range_pos = getPos(range);
+            for(size_t i = plan.first; i < plan.last; i++) {
+                XYItem item = series->getItem(i);
+                line.append(QPointF(domain->value_to_point(item.x(), area, domain_pos), range->value_to_point(item.y(), area, range_pos)));
+            }
+            marks = line;
+        }
+        if(isDrawLine()) {
+            for(int i = 0; i + 1 < line.size(); i += chunk - 1) {
+                sink->addLine(line.constData() + i, min(chunk, line.size() - i));
+            }
+            stats.points_drawn += line.size();
+        }
+        if(isDrawShape()) {
+            for(int i = 0; i < marks.size(); i += chunk) {
+                sink->addMarks(marks.constData() + i, min(chunk, marks.size() - i));
+            }
+            stats.markers += marks.size();
+        }
+    }
+    void exportScattered(SeriesSink *sink, XYSeries *series, int chunk) {
+        size_t count = series->getCount();
+        stats.points_considered += count;
+        QRect bounds = content_window.toAlignedRect();
+        if(bounds.isEmpty()) return;
+        vector<bool> marked((size_t)bounds.width() * bounds.height());
+        Pos domain_pos = getPos(domain);
+        Pos range_pos = getPos(range);
+        QVector<QPointF> line;
+        QVector<QPointF> reduced;
+        QVector<QPointF> marks;
+        ScatterRun run;
+        QPointF last;
+        bool has_last = false;
+        // Columns outside the plot are merged into one on either side.
+        qreal left = bounds.left() - 1;
+        qreal right = bounds.right() + 1;
+        for(size_t i = 0; i < count; i++) {
+            XYItem item = series->getItem(i);
+            QPointF p(domain->value_to_point(item.x(), area, domain_pos), range->value_to_point(item.y(), area, range_pos));
+            bool finite = std::isfinite(p.x()) && std::isfinite(p.y());
+            if(isDrawLine()) {
+                // Segments crossing the plot in a row make one polyline.
+                bool visible = finite && has_last && crosses(last, p, content_window);
+                if(visible) {
+                    if(run.count == 0 && line.empty()) run.add((int)floor(max(left, min(right, last.x()))), last);
+                    int column = (int)floor(max(left, min(right, p.x())));
+                    if(run.count > 0 && run.index != column) run.flush(reduced);
+                    run.add(column, p);
+                } else if(run.count > 0) {
+                    run.flush(reduced);
+                }
+                exportLine(sink, line, reduced, chunk);
+                if(!visible && !line.empty()) {
+                    if(line.size() > 1) sink->addLine(line.constData(), line.size());
+                    line.clear();
+                }
+                last = p;
+                has_last = finite;
+            }
+            if(!finite || !QRectF(bounds).contains(p)) continue;
+            QPoint pixel((int)floor(p.x()), (int)floor(p.y()));
+            if(isDrawShape() && bounds.contains(pixel)) {
+                size_t cell = (size_t)(pixel.y() - bounds.top()) * bounds.width() + (pixel.x() - bounds.left());
+                if(marked[cell]) continue;
+                marked[cell] = true;
+                marks.append(p);
+                stats.markers++;
+                if(marks.size() == chunk) {
+                    sink->addMarks(marks.constData(), marks.size());
+                    marks.clear();
+                }
+            }
+        }
+        if(run.count > 0) {
+            run.flush(reduced);
+            exportLine(sink, line, reduced, chunk);
+        }
+        if(line.size() > 1) sink->addLine(line.constData(), line.size());
+        if(!marks.empty()) sink->addMarks(marks.constData(), marks.size());
+    }
+    // Paints the series the way the screen does onto a transparent image
+    // of the plot.
+    void exportImage(SeriesSink *sink, const SeriesHolder &holder) {
+        QRect bounds = content_window.toAlignedRect();
+        if(bounds.isEmpty()) return;
+        QImage image(bounds.size(), QImage::Format_ARGB32_Premultiplied);
+        image.fill(Qt::transparent);
+        {
+            QPainter g(&image);
+            g.translate(-bounds.topLeft());
+            if(holder.isBars()) drawBars(&g, holder, content_window);
+            else drawDensity(&g, holder, content_window);
+        }
+        sink->addImage(QRectF(bounds), image);
+    }
+    // Moves points onto line, handing it to the sink whenever it holds
+    // chunk of them; the last one starts the next chunk.
+    void exportLine(SeriesSink *sink, QVector<QPointF> &line, QVector<QPointF> &points, int chunk) {
+        for(const QPointF &p : points) {
+            line.append(p);
+            stats.points_drawn++;
+            if(line.size() == chunk) {
+                sink->addLine(line.constData(), line.size());
+                line.remove(0, line.size() - 1);
+            }
+        }
+        points.clear();
+    }
+    // Whether the segment from a to b passes through rect (Liang-Barsky).
+    static bool crosses(QPointF a, QPointF b, const QRectF &rect) {
+        qreal dx = b.x() - a.x();
+        qreal dy = b.y() - a.y();
+        qreal p[4] = { -dx, dx, -dy, dy };
+        qreal q[4] = { a.x() - rect.left(), rect.right() - a.x(), a.y() - rect.top(), rect.bottom() - a.y() };
+        qreal t0 = 0;
+        qreal t1 = 1;
+        for(int k = 0; k < 4; k++) {
+            if(p[k] == 0) {
+                if(q[k] < 0) return false;
+                continue;
+            }
+            qreal t = q[k] / p[k];
+            if(p[k] < 0) t0 = max(t0, t);
+            else t1 = min(t1, t);
+            if(t0 > t1) return false;
+        }
+        return true;
+    }
+    bool isView(Range d, Range r) const {
+        Range cd = domain->getRange();
+        Range cr = range->getRange();
+        return d.min() == cd.min() && d.max() == cd.max() && r.min() == cr.min() && r.max() == cr.max();
+    }
+    void pushZoom() {
+        ZoomLevel level(domain->getRange(), range->getRange(), zoom);
+        if(layer_valid && layer_complete && !layer_draft && isView(layer_domain, layer_range)) {
+            level.frame = series_layer;
+            level.bounds = layer_bounds;
+            level.ratio = layer_ratio;
+            level.revision = revision;
+        }
+        zoom_history.push_back(level);
+        if(zoom_history.size() > ZOOM_HISTORY) zoom_history.erase(zoom_history.begin());
+        trimZoomHistory();
+    }
+    void trimZoomHistory() {
+        size_t bytes = 0;
+        for(const ZoomLevel &level : zoom_history) {
+            bytes += level.getFrameBytes();
+        }
+        for(ZoomLevel &level : zoom_history) {
+            if(bytes <= zoom_cache_limit) break;
+            bytes -= level.getFrameBytes();
+            level.frame = QImage();
+        }
+    }
+    static bool same(qreal a, qreal b) {
+        return abs(a - b) <= abs(a) * 1e-9;
+    }
     void drawSeries(QPainter* g, SeriesHolder holder, QRectF window) {
+        if(holder.style == SeriesHolder::DENSITY) {
+            drawDensity(g, holder, window);
+            return;
+        }
+        if(holder.isBars()) {
+            drawBars(g, holder, window);
+            return;
+        }
+        SeriesPlan plan = planSeries(holder.series, window);
+        drawSeries(g, holder, window, plan, plan.first, plan.last);
+    }
+    SeriesPlan planSeries(XYSeries *series, QRectF window) {
+        SeriesPlan plan;
+        size_t count = series->getCount();
+        stats.points_considered += count;
+        if(count == 0) return plan;
+        plan.last = count;
+        if(!series->isSorted()) return plan;
+        visibleRange(series, window, plan.first, plan.last);
+        stats.points_culled += count - (plan.last - min(plan.first, plan.last));
+        if(plan.first >= plan.last) return plan;
+        XYStorage *storage = series->getStorage();
+        plan.level = summaryLevel(storage, plan.first, plan.last, window.width() / column_width);
+        plan.decimated = plan.last - plan.first > DECIMATE_THRESHOLD * window.width() / column_width;
+        if(plan.level < 0 && storage->getSummaryLevels() > 0 && !storage->isResident(plan.first, plan.last)) {
+            storage->request(plan.first, plan.last);
+            plan.level = 0;
+        }
+        return plan;
+    }
+    // Draws [first, last) of a series the way plan says.
+    void drawSeries(QPainter* g, SeriesHolder holder, QRectF window, const SeriesPlan &plan, size_t first, size_t last) {
         XYSeries *series = holder.series;
         QColor base_color = holder.color;
-        size_t count = series->getCount();
-        if(count == 0) return;
+        if(first >= last) return;
         g->setClipRect(window);
 
         Pos domain_pos = getPos(domain);
         Pos range_pos = getPos(range);
 
-        QPen pen;
-        pen.setColor(base_color);
-        pen.setWidthF(1.5);
-        g->setPen(pen);
-
-        QLineF line;
-        if(isDrawLine()) {
-            for(int i = 0; i < count; i++) {
-                if(i == 0) continue;
-
+        QVector<QPointF> line;
+        QVector<QPointF> marks;
+        if(plan.level >= 0 || plan.decimated) {
+            decimate(series, first, last, plan.level, line, marks);
+            if(last - first > (size_t)line.size()) stats.points_decimated += last - first - line.size();
+        } else {
+            line.reserve(last - first);
+            for(size_t i = first; i < last; i++) {
                 XYItem item = series->getItem(i);
-                XYItem prev = series->getItem(i-1);
-                qreal x1 = domain->value_to_point(prev.x(), area, domain_pos);
-                qreal y1 = range->value_to_point(prev.y(), area, range_pos);
-                qreal x2 = domain->value_to_point(item.x(), area, domain_pos);
-                qreal y2 = range->value_to_point(item.y(), area, range_pos);
-                line.setLine(x1, y1, x2, y2);
-                g->drawLine(line);
+                qreal x = domain->value_to_point(item.x(), area, domain_pos);
+                qreal y = range->value_to_point(item.y(), area, range_pos);
+                line.append(QPointF(x, y));
             }
+            marks = line;
+        }
+
+        if(isDrawLine() && line.size() > 1) {
+            QPen pen;
+            pen.setColor(base_color);
+            pen.setWidthF(LINE_WIDTH);
+            g->setPen(pen);
+            g->setBrush(Qt::NoBrush);
+            g->drawPolyline(line.constData(), line.size());
+            stats.points_drawn += line.size();
         }
-        QRectF shape(-3, -3, 6, 6);
-        g->setPen(Qt::NoPen);
-        g->setBrush(base_color);
         if(isDrawShape()) {
-            for(int i = 0; i < count; i++) {
-                XYItem item = series->getItem(i);
-                qreal x2 = domain->value_to_point(item.x(), area, domain_pos);
-                qreal y2 = range->value_to_point(item.y(), area, range_pos);
-                g->translate(x2, y2);
-                g->drawEllipse(shape);
-                g->translate(-x2, -y2);
+            g->setPen(Qt::NoPen);
+            g->setBrush(base_color);
+            for(const QPointF &p : marks) {
+                g->drawEllipse(p, MARK_RADIUS, MARK_RADIUS);
+            }
+            stats.markers += marks.size();
+        }
+    }
+    // The grid always covers the whole plot at the device's resolution,
+    // whatever part of it window is; drafts bin a stride sample of huge
+    // series and the full count follows once the chart settles.
+    void drawDensity(QPainter* g, SeriesHolder holder, QRectF window) {
+        XYSeries *series = holder.series;
+        size_t count = series->getCount();
+        stats.points_considered += count;
+        QRect bounds = content_window.toAlignedRect();
+        if(bounds.isEmpty()) return;
+        qreal ratio = g->device()->devicePixelRatioF();
+        size_t first = 0;
+        size_t last = count;
+        if(series->isSorted()) {
+            visibleRange(series, content_window, first, last);
+            stats.points_culled += count - (last - min(first, last));
+            if(first >= last) return;
+        }
+        size_t stride = draft ? max<size_t>(1, (last - first) / DENSITY_DRAFT_SAMPLES) : 1;
+
+        DensityGrid &grid = density_grids[series];
+        if(!grid.isValid(domain, range, area, bounds, ratio) || grid.getFirst() != first || grid.getScanned() > last || grid.getStride() > stride) {
+            grid.reset(domain, getPos(domain), range, getPos(range), area, bounds, ratio, first, stride);
+        }
+        grid.bin(series->getStorage(), last, density_threads);
+        if(grid.getStride() > 1) stats.points_decimated += (last - first) - (last - first) / grid.getStride();
+
+        g->save();
+        g->setClipRect(window);
+        g->drawImage(bounds.topLeft(), grid.toImage(density_colormap));
+        g->restore();
+    }
+    // Candles are at least CANDLE_WIDTH pixels apart, band columns at least
+    // column_width. Bucket widths are rounded up to a power of two, so a
+    // pan or a zoom back to an earlier scale finds its buckets cached.
+    void drawBars(QPainter* g, SeriesHolder holder, QRectF window) {
+        XYSeries *series = holder.series;
+        size_t count = series->getCount();
+        stats.points_considered += count;
+        if(count == 0) return;
+        Pos domain_pos = getPos(domain);
+        Pos range_pos = getPos(range);
+        Range d = domain->getRange();
+        qreal pixels = domain_pos == TOP || domain_pos == BOTTOM ? area.width() : area.height();
+        if(pixels <= 0 || d.delta() <= 0) return;
+        qreal step = d.delta() / pixels * (holder.style == SeriesHolder::CANDLES ? CANDLE_WIDTH : column_width);
+        const BarLevel &bars = bar_caches[series].get(series, BarCache::levelFor(step), d.min(), d.max());
+
+        auto first = partition_point(bars.buckets.begin(), bars.buckets.end(), [&](const XYBucket &bucket) {
+            return bucket.max_x < d.min();
+        });
+        auto last = partition_point(first, bars.buckets.end(), [&](const XYBucket &bucket) {
+            return bucket.min_x <= d.max();
+        });
+        size_t ticks = series->upperBound(d.max()) - series->lowerBound(d.min());
+        stats.points_culled += count - ticks;
+        if(ticks > (size_t)(last - first)) stats.points_decimated += ticks - (last - first);
+        if(first == last) return;
+
+        qreal body = abs(domain->value_to_point(d.min() + bars.step, area, domain_pos) - domain->value_to_point(d.min(), area, domain_pos)) * CANDLE_BODY;
+        QVector<QLineF> wicks;
+        QVector<QRectF> rising;
+        QVector<QRectF> falling;
+        QPolygonF band;
+        QVector<QPointF> closes;
+        for(auto it = first; it != last; ++it) {
+            qreal x = domain->value_to_point((bars.keyOf(it->min_x) + 0.5) * bars.step, area, domain_pos);
+            qreal open = range->value_to_point(it->first_y, area, range_pos);
+            qreal high = range->value_to_point(it->max_y, area, range_pos);
+            qreal low = range->value_to_point(it->min_y, area, range_pos);
+            qreal close = range->value_to_point(it->last_y, area, range_pos);
+            if(holder.style == SeriesHolder::CANDLES) {
+                wicks.append(QLineF(x, high, x, low));
+                QRectF candle(x - body / 2, min(open, close), body, max<qreal>(abs(close - open), 1));
+                if(it->last_y >= it->first_y) rising.append(candle);
+                else falling.append(candle);
+            } else {
+                band.append(QPointF(x, high));
+                closes.append(QPointF(x, close));
             }
         }
+        stats.points_drawn += last - first;
+
+        g->save();
+        g->setClipRect(window);
+        if(holder.style == SeriesHolder::CANDLES) {
+            g->setPen(holder.color);
+            g->drawLines(wicks);
+            g->setBrush(chart_color);
+            g->drawRects(rising);
+            g->setBrush(holder.color);
+            g->drawRects(falling);
+        } else {
+            for(auto it = last; it != first;) {
+                --it;
+                qreal x = domain->value_to_point((bars.keyOf(it->min_x) + 0.5) * bars.step, area, domain_pos);
+                band.append(QPointF(x, range->value_to_point(it->min_y, area, range_pos)));
+            }
+            QColor fill = holder.color;
+            fill.setAlpha(BAND_ALPHA);
+            g->setPen(Qt::NoPen);
+            g->setBrush(fill);
+            g->drawPolygon(band);
+            QPen pen;
+            pen.setColor(holder.color);
+            pen.setWidthF(LINE_WIDTH);
+            g->setPen(pen);
+            g->setBrush(Qt::NoBrush);
+            g->drawPolyline(closes.constData(), closes.size());
+        }
+        g->restore();
+    }
+    // Index range [first, last) of a sorted series that falls inside the
+    // domain axis and the window, widened by one sample each side so lines
+    // leaving the window are still drawn.
+    void visibleRange(XYSeries *series, QRectF window, size_t &first, size_t &last) const {
+        Range r = domain->getRange();
+        qreal min_x = r.min();
+        qreal max_x = r.max();
+        Pos pos = getPos(domain);
+        if(pos == TOP || pos == BOTTOM) {
+            qreal a = domain->point_to_value(window.left(), area, pos);
+            qreal b = domain->point_to_value(window.right(), area, pos);
+            min_x = max(min_x, min(a, b));
+            max_x = min(max_x, max(a, b));
+        }
+        size_t lo = series->lowerBound(min_x);
+        size_t hi = series->upperBound(max_x);
+        first = lo > 0 ? lo - 1 : 0;
+        last = min(hi + 1, series->getCount());
+    }
+    // Coarsest storage summary level that still puts at least two buckets
+    // into every column of [first, last) spread over width columns, or -1
+    // to use raw samples.
+    int summaryLevel(XYStorage *storage, size_t first, size_t last, qreal width) const {
+        qreal per_column = (last - first) / width;
+        int level = -1;
+        for(int l = 0; l < storage->getSummaryLevels(); l++) {
+            if(storage->getSummaryBucketSize(l) * 2 <= per_column) level = l;
+        }
+        return level;
+    }
+    // Reduces [first, last) of a sorted series to first/min/max/last per
+    // pixel column (M4), which draws the same pixels as the full polyline.
+    // Drafts use columns of column_width pixels.
+    // With a summary level the buckets of that level are reduced instead of
+    // the samples, so the cost follows the chart width rather than the
+    // sample count.
+    void decimate(XYSeries *series, size_t first, size_t last, int level, QVector<QPointF> &line, QVector<QPointF> &marks) {
+        XYStorage *storage = series->getStorage();
+        Pos domain_pos = getPos(domain);
+
+        line.reserve((int)area.width() * 4 + 4);
+        marks.reserve((int)area.width() * 2 + 2);
+        DecimateColumn column;
+        if(level < 0) {
+            for(size_t i = first; i < last; i++) {
+                XYItem item = storage->at(i);
+                int index = (int)floor(domain->value_to_point(item.x(), area, domain_pos) / column_width);
+                if(!column.empty && column.index != index) flushColumn(column, line, marks);
+                column.add(index, item.y(), item.y(), item.y(), item.y());
+            }
+        } else {
+            size_t size = storage->getSummaryBucketSize(level);
+            for(size_t b = first / size; b * size < last; b++) {
+                XYBucket bucket = storage->getSummary(level, b);
+                int index = (int)floor(domain->value_to_point(bucket.min_x, area, domain_pos) / column_width);
+                if(!column.empty && column.index != index) flushColumn(column, line, marks);
+                column.add(index, bucket.first_y, bucket.min_y, bucket.max_y, bucket.last_y);
+            }
+        }
+        if(!column.empty) flushColumn(column, line, marks);
+    }
+    void flushColumn(DecimateColumn &column, QVector<QPointF> &line, QVector<QPointF> &marks) {
+        Pos range_pos = getPos(range);
+        qreal x = (column.index + 0.5) * column_width;
+        QPointF lo(x, range->value_to_point(column.min_y, area, range_pos));
+        QPointF hi(x, range->value_to_point(column.max_y, area, range_pos));
+        line.append(QPointF(x, range->value_to_point(column.first_y, area, range_pos)));
+        line.append(lo);
+        line.append(hi);
+        line.append(QPointF(x, range->value_to_point(column.last_y, area, range_pos)));
+        marks.append(lo);
+        if(column.max_y != column.min_y) marks.append(hi);
+        column.empty = true;
     }
     int scale(qreal v, qreal scale, qreal offset) const {
         return (int)(v*scale-offset);
@@ -854,17 +2032,44 @@ protected:
     void onAxisChanged(const AxisChangeEvent*) {
         fire();
     }
-    void onSeriesChanged(const SeriesChangeEvent*) {
+    // Appends past the binned samples are picked up by the next frame;
+    // anything landing before them (late samples, a ring storage turning
+    // over) moves indices, so the counts start over.
+    void onSeriesAppended(const SeriesAppendEvent* event) {
+        auto it = density_grids.find(event->series);
+        if(it != density_grids.end() && event->index < it->second.getScanned()) density_grids.erase(it);
+        auto bars = bar_caches.find(event->series);
+        if(bars != bar_caches.end()) bars->second.onAppended(event->index);
+    }
+    void onSeriesChanged(const SeriesChangeEvent* event) {
+        auto it = density_grids.find(event->series);
+        if(it != density_grids.end() && event->series->getCount() < it->second.getScanned()) density_grids.erase(it);
+        auto bars = bar_caches.find(event->series);
+        if(bars != bar_caches.end()) bars->second.onChanged(event->series->getCount());
         fire();
     }
 
 public:
     void fire() {
+        layer_valid = false;
+        revision++;
+        notify();
+    }
+    void notify() {
+        stats.fires++;
         RenderChangeEvent event(this);
         for(RenderChangeListener* listener : listeners) {
             listener->onRenderChanged(&event);
         }
     }
+    void fireOverlay(QVector<QRect> rects) {
+        stats.overlay_fires++;
+        RenderChangeEvent event(this, true);
+        event.rects = rects;
+        for(RenderChangeListener* listener : listeners) {
+            listener->onRenderChanged(&event);
+        }
+    }
 };
 
 #endif // RENDER_H
@@ -0,0 +1,63 @@
+#ifndef RENDERSTATS_H
+#define RENDERSTATS_H
+
+#include <QString>
+
+#include <vector>
+
+using namespace std;
+
+class SeriesStats {
+public:
+    QString name;
+    size_t count;
+    quint64 appended;
+    quint64 rejected;
+    size_t bytes;
+    quint64 fires;
+
+public:
+    SeriesStats() : count(0), appended(0), rejected(0), bytes(0), fires(0) {}
+};
+
+// Snapshot of what a chart did. The point counters cover the last content
+// frame only: considered is every sample of every series, culled the ones
+// outside the visible range, decimated the ones merged away by M4 or
+// summary buckets, drawn the polyline vertices handed to QPainter. The
+// other counters run over the chart's lifetime, so fires against paints
+// shows how many notifications never reached the screen.
+class RenderStats {
+public:
+    quint64 points_considered;
+    quint64 points_culled;
+    quint64 points_decimated;
+    quint64 points_drawn;
+    quint64 markers;
+    quint64 frames;
+    quint64 fires;
+    quint64 overlay_fires;
+    quint64 paints;
+    vector<SeriesStats> series;
+
+public:
+    RenderStats() : points_considered(0), points_culled(0), points_decimated(0), points_drawn(0), markers(0),
+        frames(0), fires(0), overlay_fires(0), paints(0) {}
+    void resetFrame() {
+        points_considered = 0;
+        points_culled = 0;
+        points_decimated = 0;
+        points_drawn = 0;
+        markers = 0;
+    }
+    QString toString() const {
+        QString line = QString("frame: considered %1 culled %2 decimated %3 drawn %4 markers %5; frames %6 paints %7 fires %8 overlay %9")
+                .arg(points_considered).arg(points_culled).arg(points_decimated).arg(points_drawn).arg(markers)
+                .arg(frames).arg(paints).arg(fires).arg(overlay_fires);
+        for(const SeriesStats &s : series) {
+            line += QString("; %1: %2 samples, %3 appended, %4 rejected, %5 bytes, %6 fires").arg(s.name).arg(s.count).arg(s.appended).arg(s.rejected).arg(s.bytes).arg(s.fires);
+        }
+        return line;
+    }
+};
+
+#endif // RENDERSTATS_H
@@ -1,2 +1,27 @@
 #include "series.h"
+#include "parallelsort.h"
 
+void XYSeries::sortByX(bool drop_duplicates, bool notify) {
+    if(sorted) return;
+    size_t count = storage->size();
+    vector<XYItem> items;
+    items.reserve(count);
+    for(size_t i = 0; i < count; i++) {
+        items.push_back(storage->at(i));
+    }
+    parallel_sort(items);
+    size_t dropped = 0;
+    if(drop_duplicates) {
+        dropped = unique_x(items);
+    } else {
+        for(size_t i = 1; i < count; i++) {
+            if(items[i-1].x() == items[i].x()) throw 1;
+        }
+    }
+    storage->assign(std::move(items));
+    sorted = true;
+    if(dropped > 0) {
+        recalcLimit();
+    }
+    if(notify) fire();
+}
@@ -26,6 +26,30 @@ public:
     virtual void onSeriesChanged(const SeriesChangeEvent *event) = 0;
 };
 
+class XYItem;
+
+// Sent for every batch of samples appended to a series, whether or not the
+// append notifies change listeners. index is the first position the batch
+// landed at; it is below the previous count when late samples were merged
+// into a sorted series.
+class SeriesAppendEvent {
+public:
+    XYSeries *series;
+    const XYItem *items;
+    size_t count;
+    size_t index;
+
+public:
+    SeriesAppendEvent(XYSeries* _series, const XYItem *_items, size_t _count, size_t _index) : series(_series), items(_items), count(_count), index(_index) {
+
+    }
+};
+
+class SeriesAppendListener {
+public:
+    virtual void onSeriesAppended(const SeriesAppendEvent *event) = 0;
+};
+
 class XYItem {
 private:
     qreal _x;
@@ -35,7 +59,7 @@ public:
     XYItem(qreal x, qreal y) : _x(x), _y(y) {
 
     }
-    bool operator < (XYItem& other) const {
+    bool operator < (const XYItem& other) const {
         return _x < other._x;
     }
     qreal x() const {
@@ -46,12 +70,251 @@ public:
     }
 };
 
+class XYBucket {
+public:
+    qreal min_x;
+    qreal max_x;
+    qreal min_y;
+    qreal max_y;
+    qreal first_y;
+    qreal last_y;
+
+public:
+    void reset(const XYItem &item) {
+        min_x = max_x = item.x();
+        min_y = max_y = first_y = last_y = item.y();
+    }
+    void extend(const XYItem &item) {
+        if(item.x() < min_x) min_x = item.x();
+        if(item.x() > max_x) max_x = item.x();
+        if(item.y() < min_y) min_y = item.y();
+        if(item.y() > max_y) max_y = item.y();
+        last_y = item.y();
+    }
+    // Takes in the bucket right after this one.
+    void extend(const XYBucket &next) {
+        if(next.min_x < min_x) min_x = next.min_x;
+        if(next.max_x > max_x) max_x = next.max_x;
+        if(next.min_y < min_y) min_y = next.min_y;
+        if(next.max_y > max_y) max_y = next.max_y;
+        last_y = next.last_y;
+    }
+};
+
+class XYStorage {
+public:
+    virtual ~XYStorage() {}
+    virtual size_t size() const = 0;
+    virtual XYItem at(size_t index) const = 0;
+    virtual void append(const XYItem& item) = 0;
+    virtual void appendAll(const XYItem* items, size_t count) {
+        for(size_t i = 0; i < count; i++) {
+            append(items[i]);
+        }
+    }
+    virtual void clear() = 0;
+    // Merges count samples sorted by x into place, none of them less than
+    // the sample before index. index is never below getInsertFloor(), the
+    // first sample the storage can still reorder; storages that can't
+    // reorder at all keep it at size() and never see an insert.
+    virtual void insert(size_t, const XYItem*, size_t) {
+        throw 1;
+    }
+    virtual size_t getInsertFloor() const {
+        return size();
+    }
+    // Replaces every sample, possibly taking over the vector's memory.
+    virtual void assign(vector<XYItem>&& items) {
+        clear();
+        appendAll(items.data(), items.size());
+    }
+    // Binary searches on x, only meaningful when x is sorted.
+    virtual size_t lowerBound(qreal x) const {
+        size_t lo = 0;
+        size_t hi = size();
+        while(lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if(at(mid).x() < x) lo = mid + 1;
+            else hi = mid;
+        }
+        return lo;
+    }
+    virtual size_t upperBound(qreal x) const {
+        size_t lo = 0;
+        size_t hi = size();
+        while(lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if(at(mid).x() <= x) lo = mid + 1;
+            else hi = mid;
+        }
+        return lo;
+    }
+    // Bytes of sample data held in memory.
+    virtual size_t getMemoryUsage() const {
+        return 0;
+    }
+    // The samples as one contiguous array, for storages that keep them so.
+    // Only valid until the next change.
+    virtual const XYItem* data() const {
+        return nullptr;
+    }
+    // Picks up samples written by someone other than the series and returns
+    // how many were appended since the previous call.
+    virtual size_t sync() {
+        return 0;
+    }
+    // Storages computed from other series (derivedseries.h) put the work
+    // off until sync(); this says whether there is some.
+    virtual bool isPending() const {
+        return false;
+    }
+    // Storages that already know their bounds report them here so the
+    // series doesn't have to scan every sample.
+    virtual bool getBounds(XYBucket&) const {
+        return false;
+    }
+    // Optional precomputed min/max pyramid. Level l splits the samples into
+    // consecutive buckets of getSummaryBucketSize(l) samples, coarser with
+    // every level.
+    virtual int getSummaryLevels() const {
+        return 0;
+    }
+    virtual size_t getSummaryBucketSize(int) const {
+        throw 1;
+    }
+    virtual XYBucket getSummary(int, size_t) const {
+        throw 1;
+    }
+    // Storages that page samples in from slow media report here whether
+    // [first, last) can be read without blocking. request() asks for a
+    // range to be brought in ahead of the rest; the resident revision
+    // changes every time more samples become available.
+    virtual bool isResident(size_t, size_t) const {
+        return true;
+    }
+    virtual void request(size_t, size_t) {
+
+    }
+    virtual size_t getResidentRevision() const {
+        return 0;
+    }
+};
+
+class MemoryStorage : public XYStorage {
+public:
+    // Late samples wait in a reorder buffer of at most REORDER samples and
+    // are merged into the vector when it fills up or on sync().
+    constexpr static size_t REORDER = 1 << 10;
+
+private:
+    vector<XYItem> items;
+    // Late samples sorted by x, each with where it goes in items.
+    vector<XYItem> late;
+    vector<size_t> late_at;
+
+    // Merges the reorder buffer into items, back to front in one pass over
+    // the samples after the first late one.
+    void drain() {
+        if(late.empty()) return;
+        size_t old = items.size();
+        items.resize(old + late.size(), items.back());
+        size_t src = old;
+        size_t dst = items.size();
+        for(size_t j = late.size(); j-- > 0;) {
+            while(src > late_at[j]) items[--dst] = items[--src];
+            items[--dst] = late[j];
+        }
+        late.clear();
+        late_at.clear();
+    }
+    // Index into late of the first sample at or after position index of
+    // the merged view; late[j] sits at late_at[j] + j.
+    size_t lateBefore(size_t index) const {
+        size_t lo = 0;
+        size_t hi = late.size();
+        while(lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if(late_at[mid] + mid < index) lo = mid + 1;
+            else hi = mid;
+        }
+        return lo;
+    }
+
+public:
+    size_t size() const {
+        return items.size() + late.size();
+    }
+    XYItem at(size_t index) const {
+        if(late.empty()) return items[index];
+        size_t j = lateBefore(index);
+        if(j < late.size() && late_at[j] + j == index) return late[j];
+        return items[index - j];
+    }
+    void append(const XYItem& item) {
+        items.push_back(item);
+    }
+    void appendAll(const XYItem* first, size_t count) {
+        items.insert(items.end(), first, first + count);
+    }
+    // A late sample costs a binary search plus a move within the reorder
+    // buffer; the vector is only touched when the buffer drains. Batches
+    // bigger than the buffer are merged straight away.
+    void insert(size_t index, const XYItem* first, size_t count) {
+        if(late.size() + count > REORDER) drain();
+        if(count > REORDER) {
+            index = lower_bound(items.begin(), items.end(), first[0]) - items.begin();
+            items.insert(items.end(), first, first + count);
+            inplace_merge(items.begin() + index, items.end() - count, items.end());
+            return;
+        }
+        for(size_t i = 0; i < count; i++) {
+            size_t at = lower_bound(items.begin(), items.end(), first[i]) - items.begin();
+            size_t j = upper_bound(late.begin(), late.end(), first[i]) - late.begin();
+            late.insert(late.begin() + j, first[i]);
+            late_at.insert(late_at.begin() + j, at);
+        }
+        if(late.size() > REORDER) drain();
+    }
+    size_t getInsertFloor() const {
+        return 0;
+    }
+    size_t getPendingCount() const {
+        return late.size();
+    }
+    size_t sync() {
+        drain();
+        return 0;
+    }
+    void assign(vector<XYItem>&& items) {
+        this->items.swap(items);
+        late.clear();
+        late_at.clear();
+    }
+    void clear() {
+        items.clear();
+        late.clear();
+        late_at.clear();
+    }
+    const XYItem* data() const {
+        return late.empty() ? items.data() : nullptr;
+    }
+    size_t getMemoryUsage() const {
+        return (items.capacity() + late.capacity()) * sizeof(XYItem) + late_at.capacity() * sizeof(size_t);
+    }
+};
+
 class XYSeries {
 private:
     vector<SeriesChangeListener*> listeners;
-    vector<XYItem> items;
+    vector<SeriesAppendListener*> append_listeners;
+    XYStorage *storage;
     QString name;
     bool sorted;
+    size_t stale;
+    size_t resident_revision;
+    quint64 appended_total;
+    quint64 rejected;
+    quint64 fires;
     qreal min_x;
     qreal max_x;
     qreal min_y;
@@ -59,35 +322,134 @@ private:
 
 public:
     XYSeries(QString _name, bool _sorted = true)
-        : name(_name), sorted(_sorted), min_x(0), max_x(0), min_y(0), max_y(0) {
-        clearLimit();
+        : XYSeries(_name, new MemoryStorage(), _sorted) {
+
     }
-    ~XYSeries() {
+    XYSeries(QString _name, XYStorage *_storage, bool _sorted = true)
+        : storage(_storage), name(_name), sorted(_sorted), stale(0), resident_revision(0), appended_total(0), rejected(0), fires(0), min_x(0), max_x(0), min_y(0), max_y(0) {
+        if(!storage) throw 1;
+        recalcLimit();
+    }
+    virtual ~XYSeries() {
+         delete storage;
          qDebug() << "series: " << name << " destroy";
     }
+    // A sorted series merges late samples into place, the way the storage
+    // reorders them (see XYStorage::insert). Samples too late for the
+    // storage to reorder are dropped and counted, see getRejectedCount().
     void add(XYItem item, bool notify = true) {
+        size_t index = getCount();
         if(sorted) {
-            if(items.empty() || items[items.size()-1] < item) {
-                items.push_back(item);
+            if(empty() || getItem(getCount()-1) < item) {
+                storage->append(item);
             } else {
-                throw 1;
+                const XYItem *late = &item;
+                size_t count = 1;
+                index = insertLate(late, count);
+                if(count == 0) return;
             }
         } else {
             if(indexOf(item.x()) < 0) {
-                items.push_back(item);
+                storage->append(item);
             } else {
                 throw 1;
             }
         }
         updateMinMin(item);
+        fireAppended(&item, 1, index);
         if(notify) fire();
     }
     void add(qreal x, qreal y, bool notify = true) {
         add(XYItem(x, y), notify);
     }
+    // Appends a whole batch with a single notification. The batch is
+    // validated up front so a rejected batch leaves the series untouched;
+    // late samples are handled as in add().
+    void addAll(const XYItem* batch, size_t count, bool notify = true) {
+        if(count == 0) return;
+        size_t index = getCount();
+        if(sorted) {
+            bool ordered = empty() || getItem(getCount()-1) < batch[0];
+            for(size_t i = 1; ordered && i < count; i++) {
+                ordered = batch[i-1] < batch[i];
+            }
+            if(!ordered) {
+                vector<XYItem> late(batch, batch + count);
+                sort(late.begin(), late.end());
+                const XYItem *first = late.data();
+                index = insertLate(first, count);
+                if(count == 0) return;
+                for(size_t i = 0; i < count; i++) {
+                    updateMinMin(first[i]);
+                }
+                fireAppended(first, count, index);
+                if(notify) fire();
+                return;
+            }
+        } else {
+            vector<qreal> xs;
+            xs.reserve(count);
+            for(size_t i = 0; i < count; i++) {
+                if(indexOf(batch[i].x()) >= 0) throw 1;
+                xs.push_back(batch[i].x());
+            }
+            sort(xs.begin(), xs.end());
+            if(adjacent_find(xs.begin(), xs.end()) != xs.end()) throw 1;
+        }
+        storage->appendAll(batch, count);
+        for(size_t i = 0; i < count; i++) {
+            updateMinMin(batch[i]);
+        }
+        fireAppended(batch, count, index);
+        if(notify) fire();
+    }
+    void addAll(const vector<XYItem>& batch, bool notify = true) {
+        addAll(batch.data(), batch.size(), notify);
+    }
+    // Pulls in samples appended to the storage from outside (e.g. by another
+    // process) or made resident by a background loader, and returns whether
+    // anything changed. Bounds of samples the storage has since dropped are
+    // only forgotten once a full storage worth has turned over, so the
+    // rescan stays amortized O(1) per sample.
+    bool sync(bool notify = true) {
+        size_t before = storage->size();
+        size_t appended = storage->sync();
+        size_t revision = storage->getResidentRevision();
+        bool refined = revision != resident_revision;
+        resident_revision = revision;
+        if(appended == 0) {
+            if(refined && notify) fire();
+            return refined;
+        }
+        size_t count = storage->size();
+        stale += before + appended - count;
+        if(stale >= count) {
+            recalcLimit();
+        } else {
+            for(size_t i = count - min(appended, count); i < count; i++) {
+                updateMinMin(storage->at(i));
+            }
+            if(sorted) {
+                min_x = storage->at(0).x();
+                max_x = storage->at(count-1).x();
+            }
+        }
+        if(!append_listeners.empty()) {
+            vector<XYItem> batch;
+            batch.reserve(min(appended, count));
+            for(size_t i = count - min(appended, count); i < count; i++) {
+                batch.push_back(storage->at(i));
+            }
+            fireAppended(batch.data(), batch.size(), count - batch.size());
+        } else {
+            appended_total += min(appended, count);
+        }
+        if(notify) fire();
+        return true;
+    }
     int indexOf(qreal x) const {
-        for(size_t i = 0; i < items.size(); i++) {
-            if(items[i].x() == x) {
+        for(size_t i = 0; i < storage->size(); i++) {
+            if(storage->at(i).x() == x) {
                 return (int)i;
             }
         }
@@ -109,17 +471,18 @@ public:
     }
     void clear() {
         clearLimit();
-        items.clear();
+        storage->clear();
+        stale = 0;
         fire();
     }
     bool empty() const {
-        return items.empty();
+        return storage->size() == 0;
     }
-    const XYItem& getItem(int index) const {
-        return items[index];
+    XYItem getItem(int index) const {
+        return storage->at(index);
     }
-    const XYItem& operator[] (int index) const {
-        return items[index];
+    XYItem operator[] (int index) const {
+        return storage->at(index);
     }
     QString getName() const {
         return name;
@@ -137,7 +500,41 @@ public:
         return max_y;
     }
     size_t getCount() const {
-        return items.size();
+        return storage->size();
+    }
+    bool isSorted() const {
+        return sorted;
+    }
+    // Sorts an unsorted series by x in parallel and switches it to sorted
+    // mode so it gets binary searched culling and decimation. Samples
+    // sharing an x either make it throw before anything changes or are
+    // dropped, keeping the one added first.
+    void sortByX(bool drop_duplicates = false, bool notify = true);
+    // First index whose x is not less than x; sorted series only.
+    size_t lowerBound(qreal x) const {
+        if(!sorted) throw 1;
+        return storage->lowerBound(x);
+    }
+    // First index whose x is greater than x; sorted series only.
+    size_t upperBound(qreal x) const {
+        if(!sorted) throw 1;
+        return storage->upperBound(x);
+    }
+    XYStorage* getStorage() const {
+        return storage;
+    }
+    // Samples appended over the series' lifetime and change notifications
+    // sent, for statistics.
+    quint64 getAppendedCount() const {
+        return appended_total;
+    }
+    // Late samples dropped because the storage could no longer reorder
+    // that far back.
+    quint64 getRejectedCount() const {
+        return rejected;
+    }
+    quint64 getFireCount() const {
+        return fires;
     }
     void addSeriesChangeListener(SeriesChangeListener* listener) {
         listeners.push_back(listener);
@@ -145,19 +542,75 @@ public:
     void removeSeriesChangeListener(SeriesChangeListener* listener) {
         listeners.erase(find(listeners.begin(), listeners.end(), listener));
     }
+    void addSeriesAppendListener(SeriesAppendListener* listener) {
+        append_listeners.push_back(listener);
+    }
+    void removeSeriesAppendListener(SeriesAppendListener* listener) {
+        append_listeners.erase(find(append_listeners.begin(), append_listeners.end(), listener));
+    }
+    void fireAppended(const XYItem *items, size_t count, size_t index) {
+        appended_total += count;
+        SeriesAppendEvent event(this, items, count, index);
+        for(SeriesAppendListener* listener : append_listeners) {
+            listener->onSeriesAppended(&event);
+        }
+    }
     void fire() {
+        fires++;
         SeriesChangeEvent event(this);
         for(SeriesChangeListener* listener : listeners) {
             listener->onSeriesChanged(&event);
         }
     }
 private:
+    // Merges a batch sorted by x into the storage and returns where it
+    // starts. The samples landing before the storage's insert floor come
+    // first; they are skipped and counted, leaving batch and count to what
+    // was merged. x must stay unique, so the rest is checked against itself
+    // and its neighbours before anything is touched.
+    size_t insertLate(const XYItem* &batch, size_t &count) {
+        size_t size = storage->size();
+        size_t floor = storage->getInsertFloor();
+        size_t skip = 0;
+        if(floor > 0) {
+            qreal last = storage->at(floor-1).x();
+            while(skip < count && !(last < batch[skip].x())) skip++;
+        }
+        for(size_t i = skip; i < count; i++) {
+            if(i > skip && !(batch[i-1] < batch[i])) throw 1;
+            size_t at = storage->lowerBound(batch[i].x());
+            if(at < size && storage->at(at).x() == batch[i].x()) throw 1;
+        }
+        rejected += skip;
+        batch += skip;
+        count -= skip;
+        if(count == 0) return size;
+        size_t index = storage->lowerBound(batch[0].x());
+        if(index == size) storage->appendAll(batch, count);
+        else storage->insert(index, batch, count);
+        return index;
+    }
     void clearLimit() {
         min_x = numeric_limits<qreal>::max();
         max_x = numeric_limits<qreal>::min();
         min_y = numeric_limits<qreal>::max();
         max_y = numeric_limits<qreal>::min();
     }
+    void recalcLimit() {
+        clearLimit();
+        stale = 0;
+        XYBucket bounds;
+        if(storage->getBounds(bounds)) {
+            min_x = bounds.min_x;
+            max_x = bounds.max_x;
+            min_y = bounds.min_y;
+            max_y = bounds.max_y;
+            return;
+        }
+        for(size_t i = 0; i < storage->size(); i++) {
+            updateMinMin(storage->at(i));
+        }
+    }
 };
 
 #endif // XYSERIES_H
@@ -0,0 +1,222 @@
+#ifndef SERIESFILE_H
+#define SERIESFILE_H
+
+#include <sys/types.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <vector>
+#include <limits>
+#include <algorithm>
+
+// Columnar series file, read through MappedStorage. Native endian, every
+// section starts on a 4 KiB boundary:
+//
+//   0                  SeriesFileHeader (4096 bytes)
+//   level_offset[l]    SeriesFileBucket[bucket_count[l]] for l < levels
+//   x_offset           double x[count]
+//   y_offset           double y[count]
+//
+// Summary level 0 holds one bucket per SERIES_FILE_BUCKET samples, every
+// further level one bucket per SERIES_FILE_FANOUT buckets of the level
+// below, until a level has at most SERIES_FILE_FANOUT buckets. A bucket
+// covers a contiguous index range; with sorted x it covers the x range
+// [min_x, max_x]. The summaries sit in front of the columns so a
+// zoomed-out view only ever touches the head of the file.
+
+const uint32_t SERIES_FILE_MAGIC = 0x53595853;
+const uint32_t SERIES_FILE_VERSION = 1;
+const uint32_t SERIES_FILE_SORTED = 1;
+const uint32_t SERIES_FILE_MAX_LEVELS = 8;
+const uint64_t SERIES_FILE_BUCKET = 4096;
+const uint64_t SERIES_FILE_FANOUT = 16;
+const uint64_t SERIES_FILE_ALIGN = 4096;
+
+struct SeriesFileBucket {
+    double min_x;
+    double max_x;
+    double min_y;
+    double max_y;
+    double first_y;
+    double last_y;
+};
+
+struct SeriesFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t flags;
+    uint32_t levels;
+    uint64_t count;
+    double min_x;
+    double max_x;
+    double min_y;
+    double max_y;
+    uint64_t x_offset;
+    uint64_t y_offset;
+    uint64_t bucket_size[SERIES_FILE_MAX_LEVELS];
+    uint64_t bucket_count[SERIES_FILE_MAX_LEVELS];
+    uint64_t level_offset[SERIES_FILE_MAX_LEVELS];
+    uint8_t reserved[SERIES_FILE_ALIGN - 72 - 24 * SERIES_FILE_MAX_LEVELS];
+};
+
+static_assert(sizeof(SeriesFileHeader) == SERIES_FILE_ALIGN, "SeriesFileHeader layout changed");
+static_assert(sizeof(SeriesFileBucket) == 48, "SeriesFileBucket layout changed");
+
+inline uint64_t series_file_align(uint64_t offset) {
+    return (offset + SERIES_FILE_ALIGN - 1) / SERIES_FILE_ALIGN * SERIES_FILE_ALIGN;
+}
+
+// Fills in levels, bucket sizes/counts and every section offset of header
+// for header.count samples.
+inline void series_file_layout(SeriesFileHeader &header) {
+    uint64_t offset = sizeof(SeriesFileHeader);
+    uint64_t size = SERIES_FILE_BUCKET;
+    header.levels = 0;
+    while(header.levels < SERIES_FILE_MAX_LEVELS) {
+        uint64_t buckets = (header.count + size - 1) / size;
+        if(buckets == 0) break;
+        header.bucket_size[header.levels] = size;
+        header.bucket_count[header.levels] = buckets;
+        header.level_offset[header.levels] = offset;
+        header.levels++;
+        offset = series_file_align(offset + buckets * sizeof(SeriesFileBucket));
+        if(buckets <= SERIES_FILE_FANOUT) break;
+        size *= SERIES_FILE_FANOUT;
+    }
+    header.x_offset = offset;
+    header.y_offset = series_file_align(offset + header.count * sizeof(double));
+}
+
+inline void series_file_merge(SeriesFileBucket &into, const SeriesFileBucket &b, bool first) {
+    if(first) {
+        into = b;
+        return;
+    }
+    into.min_x = std::min(into.min_x, b.min_x);
+    into.max_x = std::max(into.max_x, b.max_x);
+    into.min_y = std::min(into.min_y, b.min_y);
+    into.max_y = std::max(into.max_y, b.max_y);
+    into.last_y = b.last_y;
+}
+
+// Streams count samples into a new series file. The sample count has to be
+// known up front because it fixes where the y column starts; columns are
+// written through fixed buffers, only the summary levels are kept in memory
+// (about 1/340 of the column data). Throws 1 on I/O errors.
+class SeriesFileWriter {
+private:
+    int fd;
+    SeriesFileHeader header;
+    uint64_t written;
+    std::vector<double> xbuf;
+    std::vector<double> ybuf;
+    std::vector<std::vector<SeriesFileBucket>> levels;
+    SeriesFileBucket bucket;
+    uint64_t in_bucket;
+    bool finished;
+
+    constexpr static size_t BUFFER = 1 << 16;
+
+    void put(const void *data, size_t size, uint64_t offset) {
+        const char *p = static_cast<const char*>(data);
+        while(size > 0) {
+            ssize_t n = pwrite(fd, p, size, offset);
+            if(n <= 0) throw 1;
+            p += n;
+            size -= n;
+            offset += n;
+        }
+    }
+    void flush() {
+        if(xbuf.empty()) return;
+        uint64_t at = written - xbuf.size();
+        put(xbuf.data(), xbuf.size() * sizeof(double), header.x_offset + at * sizeof(double));
+        put(ybuf.data(), ybuf.size() * sizeof(double), header.y_offset + at * sizeof(double));
+        xbuf.clear();
+        ybuf.clear();
+    }
+
+public:
+    SeriesFileWriter(const char *path, uint64_t count, bool sorted = true) : written(0), in_bucket(0), finished(false) {
+        memset(&header, 0, sizeof(header));
+        header.magic = SERIES_FILE_MAGIC;
+        header.version = SERIES_FILE_VERSION;
+        header.flags = sorted ? SERIES_FILE_SORTED : 0;
+        header.count = count;
+        header.min_x = header.min_y = std::numeric_limits<double>::max();
+        header.max_x = header.max_y = std::numeric_limits<double>::lowest();
+        series_file_layout(header);
+        levels.resize(header.levels);
+
+        fd = ::open(path, O_CREAT | O_TRUNC | O_WRONLY, 0644);
+        if(fd < 0) throw 1;
+        if(ftruncate(fd, header.y_offset + count * sizeof(double)) < 0) {
+            ::close(fd);
+            throw 1;
+        }
+        xbuf.reserve(BUFFER);
+        ybuf.reserve(BUFFER);
+    }
+    ~SeriesFileWriter() {
+        if(fd >= 0) ::close(fd);
+    }
+    uint64_t getCount() const {
+        return header.count;
+    }
+    uint64_t getWritten() const {
+        return written;
+    }
+    void write(double x, double y) {
+        if(written == header.count) throw 1;
+        xbuf.push_back(x);
+        ybuf.push_back(y);
+        written++;
+
+        header.min_x = std::min(header.min_x, x);
+        header.max_x = std::max(header.max_x, x);
+        header.min_y = std::min(header.min_y, y);
+        header.max_y = std::max(header.max_y, y);
+        SeriesFileBucket b = { x, x, y, y, y, y };
+        series_file_merge(bucket, b, in_bucket == 0);
+        if(++in_bucket == SERIES_FILE_BUCKET) {
+            levels[0].push_back(bucket);
+            in_bucket = 0;
+        }
+        if(xbuf.size() == BUFFER) flush();
+    }
+    void write(const double *xs, const double *ys, size_t n) {
+        for(size_t i = 0; i < n; i++) {
+            write(xs[i], ys[i]);
+        }
+    }
+    // Writes the summaries and the header. Every announced sample must have
+    // been written.
+    void finish() {
+        if(finished) return;
+        if(written != header.count) throw 1;
+        flush();
+        if(in_bucket > 0) {
+            levels[0].push_back(bucket);
+            in_bucket = 0;
+        }
+        for(uint32_t l = 1; l < header.levels; l++) {
+            const std::vector<SeriesFileBucket> &below = levels[l-1];
+            for(size_t i = 0; i < below.size(); i++) {
+                if(i % SERIES_FILE_FANOUT == 0) levels[l].push_back(below[i]);
+                else series_file_merge(levels[l].back(), below[i], false);
+            }
+        }
+        for(uint32_t l = 0; l < header.levels; l++) {
+            put(levels[l].data(), levels[l].size() * sizeof(SeriesFileBucket), header.level_offset[l]);
+        }
+        put(&header, sizeof(header), 0);
+        if(fsync(fd) < 0) throw 1;
+        ::close(fd);
+        fd = -1;
+        finished = true;
+    }
+};
+
+#endif // SERIESFILE_H
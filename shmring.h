@@ -0,0 +1,56 @@
+#ifndef SHMRING_H
+#define SHMRING_H
+
+#include <atomic>
+#include <stdint.h>
+#include <stddef.h>
+
+// Sample ring in POSIX shared memory, written by a single producer process
+// and mapped read-only by any number of viewers (ShmStorage). The object is
+// created by the producer; if the viewer dies the samples stay in the ring.
+//
+// Layout, native endian:
+//
+//   0           ShmRingHeader (128 bytes)
+//   x_offset    double x[capacity]
+//   y_offset    double y[capacity]
+//
+// Sample n (counted from 0 since the stream started) lives in slot
+// n % capacity of both columns. The producer stores x and y of sample n and
+// then publishes it by storing n + 1 to write_seq with release ordering.
+// A reader loads write_seq with acquire ordering; samples
+// [max(0, write_seq - capacity), write_seq) are then readable. Slots are
+// reused after capacity samples, the producer never waits for readers.
+//
+// Before storing samples below n the producer stores n to claim_seq,
+// followed by a release fence. A reader that read samples, issued an
+// acquire fence and then loaded claim_seq knows every sample it read below
+// claim_seq - capacity may have been torn by the producer (a seqlock
+// check). Producers that never store claim_seq leave it at 0.
+//
+// generation is incremented whenever the producer restarts the stream and
+// write_seq goes back to 0.
+
+const uint32_t SHM_RING_MAGIC = 0x58595253;
+const uint32_t SHM_RING_VERSION = 1;
+
+struct ShmRingHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t capacity;
+    uint64_t x_offset;
+    uint64_t y_offset;
+    std::atomic<uint64_t> write_seq;
+    std::atomic<uint64_t> generation;
+    std::atomic<uint64_t> claim_seq;
+    uint8_t reserved[72];
+};
+
+static_assert(sizeof(ShmRingHeader) == 128, "ShmRingHeader layout changed");
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "shared-memory counters need lock-free 64-bit atomics");
+
+inline size_t shm_ring_size(uint64_t capacity) {
+    return sizeof(ShmRingHeader) + 2 * capacity * sizeof(double);
+}
+
+#endif // SHMRING_H
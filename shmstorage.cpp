@@ -0,0 +1,33 @@
+#include "shmstorage.h"
+
+XYItem ShmStorage::at(size_t index) const {
+    uint64_t n = first + index;
+    for(;;) {
+        size_t slot = n % capacity;
+        qreal x = xs[slot];
+        qreal y = ys[slot];
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t claim = header->claim_seq.load(std::memory_order_relaxed);
+        // The producer may have torn anything before claim - capacity.
+        if(claim <= capacity || n >= claim - capacity) return XYItem(x, y);
+        n = claim - capacity;
+    }
+}
+
+size_t ShmStorage::sync() {
+    uint64_t gen = header->generation.load(std::memory_order_acquire);
+    uint64_t next = header->write_seq.load(std::memory_order_acquire);
+    if(gen != generation || next < seq) {
+        generation = gen;
+        first = seq = 0;
+    }
+    uint64_t claim = header->claim_seq.load(std::memory_order_acquire);
+    // Samples before next - capacity were overwritten by newer ones, and the
+    // producer may be tearing anything before claim - capacity.
+    uint64_t oldest = next > capacity ? next - capacity : 0;
+    uint64_t valid = claim > capacity ? claim - capacity : 0;
+    first = min(next, max(first, max(oldest, valid)));
+    size_t appended = (size_t)(next - max(seq, first));
+    seq = next;
+    return appended;
+}
@@ -0,0 +1,84 @@
+#ifndef SHMSTORAGE_H
+#define SHMSTORAGE_H
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "series.h"
+#include "shmring.h"
+
+// Read-only XYStorage over a shared-memory ring (see shmring.h). Samples are
+// read straight out of the mapping; sync() is a few atomic loads.
+//
+// The producer never waits for readers, so a slot a frame is reading may be
+// rewritten under it. at() checks every read against the producer's
+// claim_seq afterwards, seqlock style; a sample that may have been torn has
+// been overwritten by a newer one, so it hands out the oldest sample still
+// intact instead.
+class ShmStorage : public XYStorage {
+private:
+    QString name;
+    void *base;
+    size_t length;
+    const ShmRingHeader *header;
+    const double *xs;
+    const double *ys;
+    uint64_t capacity;
+    uint64_t first;
+    uint64_t seq;
+    uint64_t generation;
+
+public:
+    ShmStorage(QString _name) : name(_name), base(MAP_FAILED), length(0), header(nullptr), xs(nullptr), ys(nullptr), capacity(0), first(0), seq(0), generation(0) {
+        int fd = shm_open(name.toLocal8Bit().constData(), O_RDONLY, 0);
+        if(fd < 0) throw 1;
+        struct stat st;
+        if(fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(ShmRingHeader)) {
+            ::close(fd);
+            throw 1;
+        }
+        length = st.st_size;
+        base = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if(base == MAP_FAILED) throw 1;
+
+        header = static_cast<const ShmRingHeader*>(base);
+        capacity = header->capacity;
+        if(header->magic != SHM_RING_MAGIC
+                || header->version != SHM_RING_VERSION
+                || capacity == 0
+                || shm_ring_size(capacity) > length
+                || header->x_offset + capacity * sizeof(double) > length
+                || header->y_offset + capacity * sizeof(double) > length) {
+            munmap(base, length);
+            throw 1;
+        }
+        xs = reinterpret_cast<const double*>(static_cast<const char*>(base) + header->x_offset);
+        ys = reinterpret_cast<const double*>(static_cast<const char*>(base) + header->y_offset);
+        generation = header->generation.load(std::memory_order_acquire);
+    }
+    ~ShmStorage() {
+        munmap(base, length);
+    }
+    QString getName() const {
+        return name;
+    }
+    uint64_t getCapacity() const {
+        return capacity;
+    }
+    size_t size() const {
+        return (size_t)(seq - first);
+    }
+    XYItem at(size_t index) const;
+    void append(const XYItem&) {
+        throw 1;
+    }
+    void clear() {
+        throw 1;
+    }
+    size_t sync();
+};
+
+#endif // SHMSTORAGE_H
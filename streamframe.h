@@ -0,0 +1,47 @@
+#ifndef STREAMFRAME_H
+#define STREAMFRAME_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// Binary frame pushed by a producer to StreamSource, native endian:
+//
+//   StreamFrameHeader (16 bytes)
+//   double x[count]
+//   double y[count]
+//
+// Over a local socket frames are sent back to back; over UDP every datagram
+// carries exactly one frame, so count is limited to STREAM_FRAME_MAX_UDP.
+// seq increases by one per frame and lets the reader count lost frames.
+
+const uint32_t STREAM_FRAME_MAGIC = 0x46595253;
+const uint32_t STREAM_FRAME_MAX = 1 << 20;
+const uint32_t STREAM_FRAME_MAX_UDP = (65507 - 16) / 16;
+
+struct StreamFrameHeader {
+    uint32_t magic;
+    uint32_t count;
+    uint64_t seq;
+};
+
+static_assert(sizeof(StreamFrameHeader) == 16, "StreamFrameHeader layout changed");
+
+inline size_t stream_frame_size(uint32_t count) {
+    return sizeof(StreamFrameHeader) + 2 * (size_t)count * sizeof(double);
+}
+
+// Packs count samples from separate x/y arrays into out, which must hold
+// stream_frame_size(count) bytes.
+inline void stream_frame_pack(char *out, uint64_t seq, const double *xs, const double *ys, uint32_t count) {
+    StreamFrameHeader header;
+    header.magic = STREAM_FRAME_MAGIC;
+    header.count = count;
+    header.seq = seq;
+    memcpy(out, &header, sizeof(header));
+    out += sizeof(header);
+    memcpy(out, xs, count * sizeof(double));
+    memcpy(out + count * sizeof(double), ys, count * sizeof(double));
+}
+
+#endif // STREAMFRAME_H
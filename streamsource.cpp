@@ -0,0 +1,189 @@
+#include "streamsource.h"
+
+StreamSource::StreamSource(XYSeries *series, QObject *parent) :
+    QThread(parent),
+    series(series),
+    transport(LOCAL),
+    port(0),
+    frames(0),
+    samples(0),
+    lost(0),
+    malformed(0),
+    dropped(0),
+    next_seq(0)
+{
+    if(!series) throw 1;
+}
+
+StreamSource::~StreamSource()
+{
+    stop();
+}
+
+void StreamSource::connectToServer(QString name) {
+    stop();
+    transport = LOCAL;
+    server = name;
+    start();
+}
+
+void StreamSource::bind(quint16 port) {
+    stop();
+    transport = UDP;
+    this->port = port;
+    start();
+}
+
+void StreamSource::stop() {
+    if(!isRunning()) return;
+    requestInterruption();
+    wait();
+}
+
+quint64 StreamSource::getFrameCount() const {
+    QMutexLocker lock(&mutex);
+    return frames;
+}
+
+quint64 StreamSource::getSampleCount() const {
+    QMutexLocker lock(&mutex);
+    return samples;
+}
+
+quint64 StreamSource::getLostFrameCount() const {
+    QMutexLocker lock(&mutex);
+    return lost;
+}
+
+quint64 StreamSource::getMalformedCount() const {
+    QMutexLocker lock(&mutex);
+    return malformed;
+}
+
+quint64 StreamSource::getDroppedFrameCount() const {
+    QMutexLocker lock(&mutex);
+    return dropped;
+}
+
+QString StreamSource::getError() const {
+    QMutexLocker lock(&mutex);
+    return error;
+}
+
+void StreamSource::run() {
+    next_seq = 0;
+    switch(transport) {
+    case LOCAL:
+        readLocal();
+        break;
+    case UDP:
+        readUdp();
+        break;
+    }
+}
+
+void StreamSource::readLocal() {
+    QLocalSocket socket;
+    socket.connectToServer(server);
+    if(!socket.waitForConnected(3000)) {
+        fail(socket.errorString());
+        return;
+    }
+    QByteArray buffer;
+    while(!isInterruptionRequested() && socket.state() == QLocalSocket::ConnectedState) {
+        if(!socket.waitForReadyRead(100)) continue;
+        buffer.append(socket.readAll());
+        size_t used = decode(buffer.constData(), buffer.size());
+        if(used == (size_t)-1) {
+            fail("malformed frame");
+            return;
+        }
+        buffer.remove(0, (int)used);
+    }
+}
+
+void StreamSource::readUdp() {
+    QUdpSocket socket;
+    if(!socket.bind(QHostAddress::LocalHost, port)) {
+        fail(socket.errorString());
+        return;
+    }
+    QByteArray datagram;
+    while(!isInterruptionRequested()) {
+        if(!socket.waitForReadyRead(100)) continue;
+        while(socket.hasPendingDatagrams()) {
+            datagram.resize((int)socket.pendingDatagramSize());
+            qint64 size = socket.readDatagram(datagram.data(), datagram.size());
+            if(size <= 0) continue;
+            if(decode(datagram.constData(), size) != (size_t)size) {
+                QMutexLocker lock(&mutex);
+                malformed++;
+            }
+        }
+    }
+}
+
+// Decodes every whole frame in data and queues it for the GUI thread.
+// Returns the number of bytes consumed, or -1 on a corrupt stream.
+size_t StreamSource::decode(const char *data, size_t size) {
+    size_t used = 0;
+    bool queued = false;
+    while(size - used >= sizeof(StreamFrameHeader)) {
+        StreamFrameHeader header;
+        memcpy(&header, data + used, sizeof(header));
+        if(header.magic != STREAM_FRAME_MAGIC || header.count > STREAM_FRAME_MAX) {
+            return (size_t)-1;
+        }
+        size_t frame_size = stream_frame_size(header.count);
+        if(size - used < frame_size) break;
+
+        const char *xs = data + used + sizeof(header);
+        const char *ys = xs + header.count * sizeof(double);
+        std::vector<XYItem> frame;
+        frame.reserve(header.count);
+        for(uint32_t i = 0; i < header.count; i++) {
+            double x, y;
+            memcpy(&x, xs + i * sizeof(double), sizeof(double));
+            memcpy(&y, ys + i * sizeof(double), sizeof(double));
+            frame.push_back(XYItem(x, y));
+        }
+        used += frame_size;
+
+        QMutexLocker lock(&mutex);
+        if(header.seq > next_seq) lost += header.seq - next_seq;
+        next_seq = header.seq + 1;
+        frames++;
+        samples += header.count;
+        if(pending.size() >= PENDING_MAX) {
+            pending.pop_front();
+            dropped++;
+        }
+        pending.push_back(std::move(frame));
+        queued = true;
+    }
+    if(queued) {
+        QMetaObject::invokeMethod(this, "drain", Qt::QueuedConnection);
+    }
+    return used;
+}
+
+void StreamSource::fail(QString message) {
+    QMutexLocker lock(&mutex);
+    error = message;
+    qDebug() << "stream source: " << message;
+}
+
+void StreamSource::drain() {
+    std::deque<std::vector<XYItem>> batch;
+    {
+        QMutexLocker lock(&mutex);
+        batch.swap(pending);
+    }
+    for(std::vector<XYItem> &frame : batch) {
+        try {
+            series->addAll(frame);
+        } catch(int) {
+            fail("frame rejected by series");
+        }
+    }
+}
@@ -0,0 +1,79 @@
+#ifndef STREAMSOURCE_H
+#define STREAMSOURCE_H
+
+#include <QThread>
+#include <QMutex>
+#include <QLocalSocket>
+#include <QUdpSocket>
+#include <QHostAddress>
+
+#include <deque>
+
+#include "series.h"
+#include "streamframe.h"
+
+// Feeds an XYSeries from a producer that pushes StreamFrame frames over a
+// local socket or UDP on loopback (see streamframe.h).
+//
+// Sockets are read and frames decoded on the source's own thread; every
+// decoded frame is handed to the GUI thread and lands in the series as one
+// addAll(), i.e. one notification per frame. The series must outlive the
+// source.
+//
+// A malformed datagram is dropped and counted; on a local socket the byte
+// stream can't be resynchronized, so it ends the source. At most
+// PENDING_MAX frames wait for the GUI thread; when it falls further behind
+// the oldest are dropped and counted.
+class StreamSource : public QThread
+{
+    Q_OBJECT
+
+public:
+    enum Transport {
+        LOCAL, UDP
+    };
+    constexpr static size_t PENDING_MAX = 1024;
+
+    explicit StreamSource(XYSeries *series, QObject *parent = 0);
+    ~StreamSource();
+
+    void connectToServer(QString name);
+    void bind(quint16 port);
+    void stop();
+
+    quint64 getFrameCount() const;
+    quint64 getSampleCount() const;
+    quint64 getLostFrameCount() const;
+    quint64 getMalformedCount() const;
+    quint64 getDroppedFrameCount() const;
+    QString getError() const;
+
+protected:
+    void run() override;
+
+private:
+    XYSeries *series;
+    Transport transport;
+    QString server;
+    quint16 port;
+
+    mutable QMutex mutex;
+    std::deque<std::vector<XYItem>> pending;
+    QString error;
+    quint64 frames;
+    quint64 samples;
+    quint64 lost;
+    quint64 malformed;
+    quint64 dropped;
+    quint64 next_seq;
+
+    void readLocal();
+    void readUdp();
+    size_t decode(const char *data, size_t size);
+    void fail(QString message);
+
+private slots:
+    void drain();
+};
+
+#endif // STREAMSOURCE_H
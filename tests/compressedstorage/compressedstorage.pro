@@ -0,0 +1,16 @@
+#-------------------------------------------------
+#
+# Round-trip check for the CompressedStorage codec; run with make check.
+# Links the chartcore library, so build it through engine.pro.
+#
+#-------------------------------------------------
+
+TEMPLATE = app
+TARGET = tst_compressedstorage
+CONFIG += console c++17 testcase
+CONFIG -= app_bundle
+
+include(../../linkcore.pri)
+
+SOURCES += \
+    main.cpp
@@ -0,0 +1,122 @@
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <thread>
+
+#include "compressedstorage.h"
+#include "series.h"
+
+using namespace std;
+
+// Round-trips awkward sample streams through CompressedStorage and checks
+// every sample comes back bit for bit, from several threads at once, and
+// merges late samples into a series backed by it.
+
+namespace {
+
+int failures = 0;
+
+bool same(qreal a, qreal b) {
+    return memcmp(&a, &b, sizeof(a)) == 0;
+}
+
+void check(const char *name, const vector<XYItem> &items) {
+    CompressedStorage storage;
+    for(const XYItem &item : items) storage.append(item);
+    if(storage.size() != items.size()) {
+        printf("FAIL %s: size %zu, expected %zu\n", name, storage.size(), items.size());
+        failures++;
+        return;
+    }
+    bool ok[4] = { true, true, true, true };
+    vector<thread> readers;
+    for(int t = 0; t < 4; t++) {
+        readers.push_back(thread([&, t]() {
+            for(size_t i = 0; i < items.size(); i++) {
+                size_t index = t % 2 ? items.size() - 1 - i : i;
+                XYItem item = storage.at(index);
+                if(!same(item.x(), items[index].x()) || !same(item.y(), items[index].y())) ok[t] = false;
+            }
+        }));
+    }
+    for(thread &reader : readers) reader.join();
+    for(int t = 0; t < 4; t++) {
+        if(!ok[t]) {
+            printf("FAIL %s: reader %d saw a sample that didn't round-trip\n", name, t);
+            failures++;
+            return;
+        }
+    }
+    printf("ok   %s (%zu samples, %zu bytes)\n", name, items.size(), storage.getMemoryUsage());
+}
+
+// Odd x arrive late: those still in the open tail are merged, older ones
+// are rejected and counted.
+void checkLate() {
+    const size_t n = CompressedStorage::BLOCK * 8;
+    XYSeries series("late", new CompressedStorage());
+    for(size_t i = 0; i < n; i++) series.add(2.0 * i, 0);
+    size_t floor = series.getStorage()->getInsertFloor();
+    vector<XYItem> late;
+    for(size_t i = 0; i < n; i += 97) late.push_back(XYItem(2.0 * i + 1, 1));
+    series.addAll(late);
+    size_t expected = 0;
+    for(const XYItem &item : late) {
+        if(item.x() > 2.0 * (floor - 1)) expected++;
+    }
+    bool sorted = true;
+    for(size_t i = 1; i < series.getCount(); i++) {
+        if(!(series[i-1].x() < series[i].x())) sorted = false;
+    }
+    if(!sorted || series.getCount() != n + expected || series.getRejectedCount() != late.size() - expected) {
+        printf("FAIL late samples: %zu samples, %llu rejected\n", series.getCount(), (unsigned long long)series.getRejectedCount());
+        failures++;
+        return;
+    }
+    printf("ok   late samples (%zu merged, %llu rejected)\n", expected, (unsigned long long)series.getRejectedCount());
+}
+
+}
+
+int main()
+{
+    const qreal inf = numeric_limits<qreal>::infinity();
+    const qreal nan = numeric_limits<qreal>::quiet_NaN();
+    const size_t n = CompressedStorage::BLOCK * 5 + 17;
+    mt19937_64 random(7);
+
+    vector<XYItem> regular;
+    for(size_t i = 0; i < n; i++) regular.push_back(XYItem(i * 0.001, sin(i * 0.01)));
+    check("regular", regular);
+
+    vector<XYItem> specials;
+    const qreal values[] = { nan, inf, -inf, 0.0, -0.0, numeric_limits<qreal>::denorm_min(), numeric_limits<qreal>::max(), -numeric_limits<qreal>::max() };
+    for(size_t i = 0; i < n; i++) specials.push_back(XYItem(values[i % 8], values[(i * 3 + 1) % 8]));
+    check("nan and inf", specials);
+
+    vector<XYItem> equal;
+    for(size_t i = 0; i < n; i++) equal.push_back(XYItem(i / 100, 1.5));
+    check("equal x", equal);
+
+    vector<XYItem> gaps;
+    for(size_t i = 0; i < n; i++) gaps.push_back(XYItem(i % 2 ? 1e300 * i : -1e-300 * i, i % 3 ? -inf : 1e-310));
+    check("large gaps", gaps);
+
+    vector<XYItem> bits;
+    for(size_t i = 0; i < n; i++) {
+        uint64_t x = random();
+        uint64_t y = random();
+        qreal vx;
+        qreal vy;
+        memcpy(&vx, &x, sizeof(vx));
+        memcpy(&vy, &y, sizeof(vy));
+        bits.push_back(XYItem(vx, vy));
+    }
+    check("random bit patterns", bits);
+
+    checkLate();
+
+    return failures ? 1 : 0;
+}
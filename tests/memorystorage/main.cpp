@@ -0,0 +1,91 @@
+#include <cstdio>
+#include <random>
+
+#include "series.h"
+
+using namespace std;
+
+// Feeds sorted series backed by MemoryStorage samples that arrive out of
+// order and checks none is dropped, the order holds before and after the
+// reorder buffer drains, and late samples wait in the buffer instead of
+// moving the vector.
+
+namespace {
+
+int failures = 0;
+
+bool ordered(const XYSeries &series) {
+    for(size_t i = 1; i < series.getCount(); i++) {
+        if(!(series[i-1].x() < series[i].x())) return false;
+    }
+    return true;
+}
+
+bool expect(const char *name, bool ok) {
+    if(!ok) {
+        printf("FAIL %s\n", name);
+        failures++;
+    }
+    return ok;
+}
+
+// A few late samples land in the reorder buffer, the oldest one included,
+// and only sync() merges them.
+void checkBuffered() {
+    const size_t n = 1 << 20;
+    MemoryStorage *storage = new MemoryStorage();
+    XYSeries series("buffered", storage);
+    for(size_t i = 0; i < n; i++) series.add(2.0 * i, 0, false);
+    const size_t late = MemoryStorage::REORDER / 2;
+    for(size_t i = 0; i < late; i++) series.add(2.0 * (n - 1 - i * 7) - 1, 1, false);
+    series.add(-1, 1, false);
+    if(!expect("buffered: nothing rejected", series.getRejectedCount() == 0)) return;
+    if(!expect("buffered: samples wait in the buffer", storage->getPendingCount() == late + 1)) return;
+    if(!expect("buffered: order before drain", ordered(series) && series.getCount() == n + late + 1)) return;
+    if(!expect("buffered: first sample", series[0].x() == -1)) return;
+    storage->sync();
+    if(!expect("buffered: drained", storage->getPendingCount() == 0 && storage->data() != nullptr)) return;
+    if(!expect("buffered: order after drain", ordered(series) && series.getCount() == n + late + 1)) return;
+    printf("ok   buffered late samples (%zu)\n", late + 1);
+}
+
+// A jittered feed overflows the buffer many times over.
+void checkJitter() {
+    const size_t n = 200000;
+    vector<qreal> xs;
+    for(size_t i = 0; i < n; i++) xs.push_back(i);
+    mt19937 random(11);
+    for(size_t i = 0; i + 8 < n; i += 8) shuffle(xs.begin() + i, xs.begin() + i + 8, random);
+    MemoryStorage *storage = new MemoryStorage();
+    XYSeries series("jitter", storage);
+    for(qreal x : xs) series.add(x, x, false);
+    bool ok = series.getRejectedCount() == 0 && series.getCount() == n && ordered(series)
+            && storage->getPendingCount() <= MemoryStorage::REORDER;
+    storage->sync();
+    ok = ok && ordered(series) && series[0].x() == 0 && series[n-1].x() == n - 1;
+    if(!expect("jittered feed", ok)) return;
+    printf("ok   jittered feed (%zu samples)\n", n);
+}
+
+// A late batch bigger than the buffer is merged straight away.
+void checkBatch() {
+    const size_t n = 100000;
+    MemoryStorage *storage = new MemoryStorage();
+    XYSeries series("batch", storage);
+    for(size_t i = 0; i < n; i++) series.add(2.0 * i, 0, false);
+    vector<XYItem> late;
+    for(size_t i = 0; i < MemoryStorage::REORDER * 3; i++) late.push_back(XYItem(2.0 * i + 1, 1));
+    series.addAll(late, false);
+    if(!expect("late batch", storage->getPendingCount() == 0 && ordered(series) && series.getCount() == n + late.size())) return;
+    printf("ok   late batch (%zu samples)\n", late.size());
+}
+
+}
+
+int main()
+{
+    checkBuffered();
+    checkJitter();
+    checkBatch();
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,16 @@
+#-------------------------------------------------
+#
+# Late-sample checks for MemoryStorage's reorder buffer; run with make
+# check. Links the chartcore library, so build it through engine.pro.
+#
+#-------------------------------------------------
+
+TEMPLATE = app
+TARGET = tst_memorystorage
+CONFIG += console c++17 testcase
+CONFIG -= app_bundle
+
+include(../../linkcore.pri)
+
+SOURCES += \
+    main.cpp
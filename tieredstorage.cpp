@@ -0,0 +1,200 @@
+#include "tieredstorage.h"
+
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+const size_t CHUNK_BYTES = TieredStorage::CHUNK * sizeof(XYItem);
+
+}
+
+void CoarseBounds::add(size_t index, const XYItem &item) {
+    if(index % size != 0) {
+        buckets.back().extend(item);
+        return;
+    }
+    if(buckets.size() == MAX) {
+        for(size_t i = 0; i < MAX / 2; i++) {
+            buckets[i] = buckets[2 * i];
+            buckets[i].extend(buckets[2 * i + 1]);
+        }
+        buckets.resize(MAX / 2);
+        size *= 2;
+    }
+    if(index % size == 0) {
+        buckets.push_back(XYBucket());
+        buckets.back().reset(item);
+    } else {
+        buckets.back().extend(item);
+    }
+}
+
+// Drops the bounds past count, rebuilding the last partial bucket from the
+// samples still in the storage.
+void CoarseBounds::truncate(size_t count, const XYStorage *storage) {
+    size_t first = min(buckets.size(), count / size);
+    buckets.resize(first);
+    for(size_t i = first * size; i < count; i++) add(i, storage->at(i));
+}
+
+TieredStorage::TieredStorage(QString path, size_t budget) :
+    path(path),
+    budget(budget),
+    cold(0),
+    buckets(BUCKET),
+    chunk_bounds(CHUNK),
+    count(0),
+    last_chunk(-1),
+    last_data(nullptr)
+{
+    fd = ::open(path.toLocal8Bit().constData(), O_CREAT | O_TRUNC | O_RDWR, 0600);
+    if(fd < 0) throw 1;
+}
+
+TieredStorage::~TieredStorage()
+{
+    unmapAll();
+    ::close(fd);
+    ::unlink(path.toLocal8Bit().constData());
+}
+
+void TieredStorage::setBudget(size_t budget) {
+    this->budget = budget;
+    while(hot.size() > 1 && hot.size() * CHUNK_BYTES > budget) spill();
+}
+
+void TieredStorage::append(const XYItem &item) {
+    if(hot.empty() || hot.back().size() == CHUNK) {
+        hot.push_back(vector<XYItem>());
+        hot.back().reserve(CHUNK);
+        while(hot.size() > 1 && hot.size() * CHUNK_BYTES > budget) spill();
+    }
+    buckets.add(count, item);
+    chunk_bounds.add(count, item);
+    hot.back().push_back(item);
+    count++;
+}
+
+// Merges a sorted run into the chunks still in RAM: everything from index
+// on is taken out and appended again together with the run.
+void TieredStorage::insert(size_t index, const XYItem *items, size_t count) {
+    if(index < cold * CHUNK) throw 1;
+    vector<XYItem> rest;
+    rest.reserve(this->count - index);
+    for(size_t i = index; i < this->count; i++) rest.push_back(at(i));
+    truncate(index);
+    size_t i = 0;
+    size_t j = 0;
+    while(i < rest.size() || j < count) {
+        if(j == count || (i < rest.size() && rest[i] < items[j])) append(rest[i++]);
+        else append(items[j++]);
+    }
+}
+
+// Cuts the storage back to its first count samples, which must all still
+// be in RAM past the spilled chunks.
+void TieredStorage::truncate(size_t count) {
+    size_t chunks = (count + CHUNK - 1) / CHUNK;
+    while(cold + hot.size() > chunks) hot.pop_back();
+    if(count % CHUNK != 0) hot.back().erase(hot.back().begin() + count % CHUNK, hot.back().end());
+    this->count = count;
+    buckets.truncate(count, this);
+    chunk_bounds.truncate(count, this);
+}
+
+// Appends the oldest chunk in RAM to the spill file and releases it.
+void TieredStorage::spill() {
+    const vector<XYItem> &data = hot.front();
+    off_t offset = (off_t)cold * CHUNK_BYTES;
+    const char *p = reinterpret_cast<const char*>(data.data());
+    size_t left = CHUNK_BYTES;
+    while(left > 0) {
+        ssize_t n = pwrite(fd, p, left, offset);
+        if(n <= 0) throw 1;
+        p += n;
+        left -= n;
+        offset += n;
+    }
+    hot.pop_front();
+    cold++;
+}
+
+// Reads a spilled sample, mapping its chunk back in if needed. The item is
+// copied out under the lock since another reader may unmap the chunk
+// right after.
+XYItem TieredStorage::readCold(size_t index) const {
+    size_t c = index / CHUNK;
+    QMutexLocker lock(&mutex);
+    if(c != last_chunk) {
+        const XYItem *data = nullptr;
+        for(const std::pair<size_t, const XYItem*> &m : mapped) {
+            if(m.first == c) data = m.second;
+        }
+        if(!data) {
+            size_t limit = max((size_t)2, budget / CHUNK_BYTES);
+            while(mapped.size() >= limit) {
+                munmap(const_cast<XYItem*>(mapped.front().second), CHUNK_BYTES);
+                mapped.pop_front();
+            }
+            void *p = mmap(nullptr, CHUNK_BYTES, PROT_READ, MAP_SHARED, fd, (off_t)c * CHUNK_BYTES);
+            if(p == MAP_FAILED) throw 1;
+            data = static_cast<const XYItem*>(p);
+            mapped.push_back(std::make_pair(c, data));
+        }
+        last_chunk = c;
+        last_data = data;
+    }
+    return last_data[index % CHUNK];
+}
+
+void TieredStorage::unmapAll() const {
+    QMutexLocker lock(&mutex);
+    for(const std::pair<size_t, const XYItem*> &m : mapped) {
+        munmap(const_cast<XYItem*>(m.second), CHUNK_BYTES);
+    }
+    mapped.clear();
+    last_chunk = -1;
+    last_data = nullptr;
+}
+
+void TieredStorage::clear() {
+    unmapAll();
+    hot.clear();
+    buckets.clear();
+    chunk_bounds.clear();
+    cold = 0;
+    count = 0;
+    if(ftruncate(fd, 0) < 0) throw 1;
+}
+
+// Narrows the search to one bucket using the bounds kept in RAM, so only
+// the chunk holding the answer is touched.
+size_t TieredStorage::search(qreal x, bool upper) const {
+    const vector<XYBucket> &b = buckets.buckets;
+    size_t lo = 0;
+    size_t hi = b.size();
+    while(lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if(upper ? b[mid].max_x <= x : b[mid].max_x < x) lo = mid + 1;
+        else hi = mid;
+    }
+    lo = min(count, lo * buckets.size);
+    hi = min(count, lo + buckets.size);
+    while(lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        qreal v = at(mid).x();
+        if(upper ? v <= x : v < x) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+size_t TieredStorage::getMemoryUsage() const {
+    size_t bytes = 0;
+    for(const vector<XYItem> &c : hot) {
+        bytes += c.capacity() * sizeof(XYItem);
+    }
+    return bytes + (buckets.buckets.capacity() + chunk_bounds.buckets.capacity()) * sizeof(XYBucket);
+}
@@ -0,0 +1,115 @@
+#ifndef TIEREDSTORAGE_H
+#define TIEREDSTORAGE_H
+
+#include <deque>
+#include <QMutex>
+
+#include "series.h"
+
+// Bounds of consecutive buckets of size samples. Once there would be more
+// than MAX buckets, neighbours are merged and the size doubles, so memory
+// stays bounded however long the storage runs.
+class CoarseBounds {
+public:
+    constexpr static size_t MAX = 1 << 16;
+
+    size_t size;
+    vector<XYBucket> buckets;
+
+    CoarseBounds(size_t _size) : size(_size), first_size(_size) {}
+    void add(size_t index, const XYItem &item);
+    void truncate(size_t count, const XYStorage *storage);
+    void clear() {
+        size = first_size;
+        buckets.clear();
+    }
+
+private:
+    size_t first_size;
+};
+
+// XYStorage for always-on monitors: samples are kept in chunks of CHUNK
+// samples, the newest in RAM. Once the chunks in RAM exceed the budget the
+// oldest (full, immutable) chunk is appended to a spill file and dropped
+// from RAM. Spilled chunks are mapped back in only when a read touches them,
+// and at most a budget's worth of them stay mapped.
+//
+// Bounds of every BUCKET samples (level 0) and every chunk (level 1) stay in
+// RAM, coarsened once there are CoarseBounds::MAX of them, so zoomed-out
+// views never touch the spill file. Late samples can be inserted among the
+// chunks still in RAM. Reads may run on any number of threads while nothing
+// is appended. The file is removed when the storage is destroyed.
+class TieredStorage : public XYStorage {
+public:
+    constexpr static size_t CHUNK = 1 << 16;
+    constexpr static size_t BUCKET = 4096;
+
+private:
+    QString path;
+    int fd;
+    size_t budget;
+    size_t cold;
+    std::deque<vector<XYItem>> hot;
+    CoarseBounds buckets;
+    CoarseBounds chunk_bounds;
+    size_t count;
+    // Spilled chunks mapped back in; only touched under the mutex.
+    mutable QMutex mutex;
+    mutable std::deque<std::pair<size_t, const XYItem*>> mapped;
+    mutable size_t last_chunk;
+    mutable const XYItem *last_data;
+
+    void spill();
+    XYItem readCold(size_t index) const;
+    void unmapAll() const;
+    void truncate(size_t count);
+    size_t search(qreal x, bool upper) const;
+
+public:
+    // budget is the RAM, in bytes, for in-memory and mapped chunks each.
+    TieredStorage(QString path, size_t budget = 64 << 20);
+    ~TieredStorage();
+
+    QString getPath() const {
+        return path;
+    }
+    size_t getBudget() const {
+        return budget;
+    }
+    void setBudget(size_t budget);
+    size_t getSpilledCount() const {
+        return cold * CHUNK;
+    }
+    size_t size() const {
+        return count;
+    }
+    XYItem at(size_t index) const {
+        size_t c = index / CHUNK;
+        if(c >= cold) return hot[c - cold][index % CHUNK];
+        return readCold(index);
+    }
+    void append(const XYItem& item);
+    void insert(size_t index, const XYItem* items, size_t count);
+    size_t getInsertFloor() const {
+        return cold * CHUNK;
+    }
+    void clear();
+    size_t lowerBound(qreal x) const {
+        return search(x, false);
+    }
+    size_t upperBound(qreal x) const {
+        return search(x, true);
+    }
+    size_t getMemoryUsage() const;
+    int getSummaryLevels() const {
+        return count > 0 ? 2 : 0;
+    }
+    size_t getSummaryBucketSize(int level) const {
+        return level == 0 ? buckets.size : chunk_bounds.size;
+    }
+    XYBucket getSummary(int level, size_t index) const {
+        return level == 0 ? buckets.buckets[index] : chunk_bounds.buckets[index];
+    }
+};
+
+#endif // TIEREDSTORAGE_H
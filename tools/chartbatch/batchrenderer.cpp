@@ -0,0 +1,112 @@
+#include "batchrenderer.h"
+
+#include <QPainter>
+
+#include "csvloader.h"
+#include "mappedstorage.h"
+#include "parallelsort.h"
+#include "recorder.h"
+#include "vectorexport.h"
+
+const vector<XYItem>& SourceCache::get(const BatchSeries &series) {
+    shared_ptr<Entry> entry;
+    {
+        lock_guard<mutex> l(lock);
+        shared_ptr<Entry> &slot = entries[series.path];
+        if(!slot) slot = make_shared<Entry>();
+        entry = slot;
+    }
+    call_once(entry->loaded, [&]() {
+        try {
+            if(series.kind == BatchSeries::CSV) {
+                // Jobs already run one per core.
+                CsvLoader loader(series.path);
+                loader.setThreads(1);
+                entry->items = loader.parse();
+                if(!loader.isSorted()) {
+                    parallel_sort(entry->items, 1);
+                    unique_x(entry->items);
+                }
+            } else {
+                XYSeries scratch(series.path);
+                SeriesRecorder::replay(series.path, &scratch, false);
+                entry->items.reserve(scratch.getCount());
+                for(size_t i = 0; i < scratch.getCount(); i++) entry->items.push_back(scratch.getItem(i));
+            }
+        } catch(int) {
+            entry->failed = true;
+        }
+    });
+    if(entry->failed) throw 1;
+    return entry->items;
+}
+
+BatchRenderer::BatchRenderer(SourceCache &cache) :
+    cache(cache)
+{
+    Axis *domain = new Axis("", 0, 1);
+    domain->setAutoRange(true);
+    Axis *range = new Axis("", 0, 1);
+    range->setAutoRange(true);
+    render = new XYRender(false, true);
+    render->setDomainAxis(domain);
+    render->setRangeAxis(range);
+    // Reports are drawn once, at full quality.
+    render->setFrameBudget(0, false);
+    // Jobs already run one per core.
+    render->setDensityThreads(1);
+}
+
+BatchRenderer::~BatchRenderer()
+{
+    clear();
+    delete render;
+}
+
+void BatchRenderer::clear() {
+    while(render->getSeriesCount() > 0) {
+        XYSeries *series = render->getSeries(0);
+        render->removeSeries(series);
+        delete series;
+    }
+}
+
+void BatchRenderer::run(const BatchJob &job) {
+    clear();
+    for(const BatchSeries &source : job.series) {
+        XYSeries *series;
+        if(source.kind == BatchSeries::MAPPED) {
+            MappedStorage *storage = new MappedStorage(source.path);
+            series = new XYSeries(source.name, storage, storage->isSorted());
+        } else {
+            const vector<XYItem> &items = cache.get(source);
+            series = new XYSeries(source.name);
+            series->addAll(items, false);
+        }
+        render->addSeries(series, source.color);
+        render->setSeriesStyle(render->getSeriesCount() - 1, source.style, false);
+    }
+    render->setTitle(job.title, false);
+    render->setDrawLine(job.line, false);
+    render->setDrawShape(job.markers, false);
+    render->setDrawGrid(job.grid, false);
+
+    QSize size(job.width, job.height);
+    if(job.out.endsWith(".svg")) {
+        if(!VectorExport::writeSvg(render, job.out, size)) throw 1;
+        return;
+    }
+    if(job.out.endsWith(".pdf")) {
+        if(!VectorExport::writePdf(render, job.out, size)) throw 1;
+        return;
+    }
+    if(image.size() != size * job.ratio) {
+        image = QImage(size * job.ratio, QImage::Format_ARGB32_Premultiplied);
+    }
+    image.setDevicePixelRatio(job.ratio);
+    {
+        QPainter g(&image);
+        render->paint(&g, size);
+    }
+    if(!image.save(job.out, "PNG")) throw 1;
+}
@@ -0,0 +1,89 @@
+#ifndef BATCHRENDERER_H
+#define BATCHRENDERER_H
+
+#include <QColor>
+#include <QImage>
+#include <QString>
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "render.h"
+
+using namespace std;
+
+class BatchSeries {
+public:
+    enum Kind { CSV, RECORDING, MAPPED };
+
+    Kind kind;
+    QString path;
+    QString name;
+    QColor color;
+    SeriesHolder::Style style;
+
+public:
+    BatchSeries() : kind(CSV), style(SeriesHolder::PLOT) {}
+};
+
+// One chart to render to a PNG, or to SVG or PDF when out ends in .svg
+// or .pdf (see vectorexport.h).
+class BatchJob {
+public:
+    QString out;
+    QString title;
+    int width;
+    int height;
+    qreal ratio;
+    bool line;
+    bool markers;
+    bool grid;
+    vector<BatchSeries> series;
+
+public:
+    BatchJob() : width(800), height(400), ratio(1), line(true), markers(false), grid(true) {}
+};
+
+// Parsed CSVs and recordings, shared between jobs and threads. Each path
+// is loaded once, by whichever job asks first; the others wait for it.
+class SourceCache {
+private:
+    class Entry {
+    public:
+        once_flag loaded;
+        vector<XYItem> items;
+        bool failed;
+
+    public:
+        Entry() : failed(false) {}
+    };
+
+    mutex lock;
+    map<QString, shared_ptr<Entry>> entries;
+
+public:
+    const vector<XYItem>& get(const BatchSeries &series);
+};
+
+// Renders jobs one after another on the calling thread. The render, its
+// axes and fonts, and the image are kept between jobs; only the series
+// change.
+class BatchRenderer {
+private:
+    SourceCache &cache;
+    XYRender *render;
+    QImage image;
+
+    void clear();
+
+public:
+    BatchRenderer(SourceCache &cache);
+    ~BatchRenderer();
+
+    // Throws when a source can't be loaded or the output can't be written.
+    void run(const BatchJob &job);
+};
+
+#endif // BATCHRENDERER_H
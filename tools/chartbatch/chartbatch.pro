@@ -0,0 +1,21 @@
+#-------------------------------------------------
+#
+# Widgetless batch renderer from chart specs to PNG. Links the chartcore
+# library, so build it through engine.pro.
+#
+#-------------------------------------------------
+
+TEMPLATE = app
+TARGET = chartbatch
+CONFIG += console c++17
+CONFIG -= app_bundle
+
+include(../../linkcore.pri)
+unix: LIBS += -lpthread
+
+SOURCES += \
+    main.cpp \
+    batchrenderer.cpp
+
+HEADERS += \
+    batchrenderer.h
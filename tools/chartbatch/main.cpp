@@ -0,0 +1,148 @@
+#include <QGuiApplication>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+#include "batchrenderer.h"
+
+using namespace std;
+
+// Renders chart specs to PNG, SVG or PDF files (by the out extension)
+// without any widget, one worker thread per core:
+//
+//   chartbatch [--jobs N] spec.json [spec.json ...]
+//
+// A spec holds defaults for its charts and the charts themselves:
+//
+//   {
+//     "width": 800, "height": 400, "ratio": 1,
+//     "charts": [
+//       {"out": "cpu.png", "title": "CPU", "markers": false, "grid": true,
+//        "series": [{"csv": "cpu.csv", "name": "cpu", "color": "#3060ff"},
+//                   {"recording": "load.xyr"},
+//                   {"file": "trace.xys", "color": "darkred"},
+//                   {"file": "hits.xys", "style": "density"},
+//                   {"file": "ticks.xys", "style": "candles"}]}
+//     ]
+//   }
+//
+// csv and recording sources are parsed once however many charts use them;
+// file sources (seriesfile.h) are mapped per chart.
+
+namespace {
+
+void parseSpec(QString path, vector<BatchJob> &jobs) {
+    QFile file(path);
+    if(!file.open(QIODevice::ReadOnly)) throw 1;
+    QJsonParseError error;
+    QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &error);
+    if(error.error != QJsonParseError::NoError || !doc.isObject()) throw 1;
+    QJsonObject spec = doc.object();
+
+    BatchJob defaults;
+    defaults.width = spec.value("width").toInt(defaults.width);
+    defaults.height = spec.value("height").toInt(defaults.height);
+    defaults.ratio = spec.value("ratio").toDouble(defaults.ratio);
+
+    for(const QJsonValue &value : spec.value("charts").toArray()) {
+        QJsonObject chart = value.toObject();
+        BatchJob job = defaults;
+        job.out = chart.value("out").toString();
+        if(job.out.isEmpty()) throw 1;
+        job.title = chart.value("title").toString();
+        job.width = chart.value("width").toInt(job.width);
+        job.height = chart.value("height").toInt(job.height);
+        job.ratio = chart.value("ratio").toDouble(job.ratio);
+        job.line = chart.value("line").toBool(job.line);
+        job.markers = chart.value("markers").toBool(job.markers);
+        job.grid = chart.value("grid").toBool(job.grid);
+        if(job.width <= 0 || job.height <= 0 || job.ratio <= 0) throw 1;
+
+        for(const QJsonValue &s : chart.value("series").toArray()) {
+            QJsonObject source = s.toObject();
+            BatchSeries series;
+            if(source.contains("csv")) {
+                series.kind = BatchSeries::CSV;
+                series.path = source.value("csv").toString();
+            } else if(source.contains("recording")) {
+                series.kind = BatchSeries::RECORDING;
+                series.path = source.value("recording").toString();
+            } else if(source.contains("file")) {
+                series.kind = BatchSeries::MAPPED;
+                series.path = source.value("file").toString();
+            } else {
+                throw 1;
+            }
+            series.name = source.value("name").toString(series.path);
+            series.color = QColor(source.value("color").toString("red"));
+            QString style = source.value("style").toString("plot");
+            if(style == "plot") series.style = SeriesHolder::PLOT;
+            else if(style == "density") series.style = SeriesHolder::DENSITY;
+            else if(style == "candles") series.style = SeriesHolder::CANDLES;
+            else if(style == "band") series.style = SeriesHolder::BAND;
+            else throw 1;
+            job.series.push_back(series);
+        }
+        jobs.push_back(job);
+    }
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    if(qgetenv("QT_QPA_PLATFORM").isEmpty()) qputenv("QT_QPA_PLATFORM", "offscreen");
+    QGuiApplication a(argc, argv);
+
+    QStringList args = a.arguments();
+    int threads = (int)thread::hardware_concurrency();
+    vector<BatchJob> jobs;
+    for(int i = 1; i < args.size(); i++) {
+        if(args[i] == "--jobs" && i + 1 < args.size()) {
+            threads = args[++i].toInt();
+            continue;
+        }
+        try {
+            parseSpec(args[i], jobs);
+        } catch(int) {
+            fprintf(stderr, "chartbatch: bad spec %s\n", args[i].toLocal8Bit().constData());
+            return 1;
+        }
+    }
+    if(jobs.empty()) {
+        fprintf(stderr, "usage: chartbatch [--jobs N] spec.json [spec.json ...]\n");
+        return 1;
+    }
+    threads = max(1, min(threads, (int)jobs.size()));
+
+    SourceCache cache;
+    atomic<size_t> next(0);
+    atomic<size_t> failed(0);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    vector<thread> workers;
+    for(int t = 0; t < threads; t++) {
+        workers.push_back(thread([&]() {
+            BatchRenderer renderer(cache);
+            for(size_t i = next++; i < jobs.size(); i = next++) {
+                try {
+                    renderer.run(jobs[i]);
+                } catch(int) {
+                    failed++;
+                    fprintf(stderr, "chartbatch: can't render %s\n", jobs[i].out.toLocal8Bit().constData());
+                }
+            }
+        }));
+    }
+    for(thread &worker : workers) worker.join();
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    fprintf(stderr, "%zu charts, %zu failed, %d threads, %.1f ms, %.2f ms per chart\n",
+            jobs.size(), failed.load(), threads, ms, ms / jobs.size());
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,16 @@
+#-------------------------------------------------
+#
+# Offscreen throughput benchmark for the chart engine. Links the chartcore
+# library, so build it through engine.pro.
+#
+#-------------------------------------------------
+
+TEMPLATE = app
+TARGET = chartbench
+CONFIG += console c++17
+CONFIG -= app_bundle
+
+include(../../linkcore.pri)
+
+SOURCES += \
+    main.cpp
@@ -0,0 +1,269 @@
+#include <QApplication>
+#include <QImage>
+#include <QPainter>
+#include <QWidget>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <vector>
+
+#include "axis.h"
+#include "series.h"
+#include "render.h"
+#include "numericlocale.h"
+
+using namespace std;
+
+// Times the engine headless, for every size from 1e3 up to --max samples:
+//
+//   chartbench [--max 100000000] [--out bench.json] [--width 1280] [--height 720]
+//
+// Runs on the offscreen platform unless QT_QPA_PLATFORM says otherwise and
+// writes one JSON object per measurement to --out, or to stdout.
+
+namespace {
+
+typedef chrono::steady_clock Clock;
+
+class Result {
+public:
+    const char *name;
+    size_t size;
+    int iterations;
+    double median_ms;
+    double min_ms;
+    double per_item_ns;
+    quint64 drawn;
+};
+
+double elapsedMs(Clock::time_point start) {
+    return chrono::duration<double, milli>(Clock::now() - start).count();
+}
+
+// Repeats body until it has run at least 3 times and for the budget, or
+// for 100 runs, or for 10 budgets when a single run is that slow.
+Result measure(const char *name, size_t size, size_t items, function<void()> body, double budget = 250) {
+    vector<double> times;
+    double total = 0;
+    while(times.size() < 100 && total < 10 * budget && (times.size() < 3 || total < budget)) {
+        Clock::time_point start = Clock::now();
+        body();
+        double ms = elapsedMs(start);
+        times.push_back(ms);
+        total += ms;
+    }
+    sort(times.begin(), times.end());
+    Result result;
+    result.name = name;
+    result.size = size;
+    result.iterations = (int)times.size();
+    result.median_ms = times[times.size() / 2];
+    result.min_ms = times[0];
+    result.per_item_ns = items ? result.median_ms * 1e6 / items : 0;
+    result.drawn = 0;
+    return result;
+}
+
+// Single pass, for work that can't be repeated on the same state.
+Result once(const char *name, size_t size, size_t items, function<void()> body) {
+    Clock::time_point start = Clock::now();
+    body();
+    double ms = elapsedMs(start);
+    Result result;
+    result.name = name;
+    result.size = size;
+    result.iterations = 1;
+    result.median_ms = ms;
+    result.min_ms = ms;
+    result.per_item_ns = items ? ms * 1e6 / items : 0;
+    result.drawn = 0;
+    return result;
+}
+
+inline qreal sample(size_t i) {
+    qreal x = i * 1e-3;
+    return sin(x * 0.01) + 0.3 * sin(x * 1.7) + 0.05 * sin(i * 12.9898);
+}
+
+class Bench {
+private:
+    XYRender *render;
+    Axis *domain;
+    Axis *range;
+    QWidget widget;
+    QImage image;
+    vector<Result> results;
+
+public:
+    Bench(int width, int height) :
+        render(new XYRender()),
+        domain(new Axis("x", 0, 1)),
+        range(new Axis("y", 0, 1)),
+        image(width, height, QImage::Format_ARGB32_Premultiplied)
+    {
+        widget.resize(width, height);
+        render->setDomainAxis(domain);
+        render->setRangeAxis(range);
+        // Every frame at full quality, so numbers don't depend on the last one.
+        render->setFrameBudget(0, false);
+    }
+    ~Bench() {
+        delete render;
+    }
+    const vector<Result>& getResults() const {
+        return results;
+    }
+    // Invalidates the series layer so each run renders it from the data.
+    void paint(bool overlay_only = false) {
+        QPainter g(&image);
+        if(overlay_only) {
+            render->paintOverlay(&g);
+            return;
+        }
+        render->fire();
+        render->paint(&g, &widget);
+    }
+    Result paintResult(const char *name, size_t size) {
+        Result result = measure(name, size, 1, [this]() { paint(); });
+        result.per_item_ns = 0;
+        result.drawn = render->getStats().points_drawn;
+        return result;
+    }
+    void run(size_t n) {
+        XYSeries *raw = new XYSeries("raw");
+        results.push_back(once("append", n, n, [raw, n]() {
+            for(size_t i = 0; i < n; i++) raw->add(i * 1e-3, sample(i), false);
+        }));
+        delete raw;
+
+        XYSeries *series = new XYSeries("bench");
+        render->addSeries(series);
+        results.push_back(once("append_batch", n, n, [series, n]() {
+            const size_t chunk = 4096;
+            vector<XYItem> batch;
+            batch.reserve(chunk);
+            for(size_t i = 0; i < n; i += chunk) {
+                batch.clear();
+                for(size_t j = i; j < min(n, i + chunk); j++) batch.push_back(XYItem(j * 1e-3, sample(j)));
+                series->addAll(batch);
+            }
+        }));
+
+        results.push_back(measure("auto_range", n, 0, [this]() {
+            domain->setRange(render->calc_series_bound(domain, Pos::BOTTOM), false);
+            range->setRange(render->calc_series_bound(range, Pos::LEFT), false);
+        }));
+
+        domain->setAutoRange(true, false);
+        range->setAutoRange(true, false);
+        render->setDrawLine(true, false);
+        render->setDrawShape(false, false);
+        results.push_back(paintResult("paint_full", n));
+
+        render->setDrawLine(false, false);
+        render->setDrawShape(true, false);
+        results.push_back(paintResult("paint_markers", n));
+        render->setDrawLine(true, false);
+        render->setDrawShape(false, false);
+
+        // The middle 1% of the domain.
+        domain->setAutoRange(false, false);
+        range->setAutoRange(false, false);
+        Range d = domain->getRange();
+        qreal center = (d.min() + d.max()) / 2;
+        qreal half = (d.max() - d.min()) / 200;
+        domain->setRange(center - half, center + half, false);
+        results.push_back(paintResult("paint_zoomed", n));
+        domain->setRange(d, false);
+        paint();
+
+        QRectF area = render->getArea();
+        QPoint origin = area.center().toPoint();
+        const int steps = 200;
+        render->startGesture(Qt::LeftButton, origin);
+        results.push_back(once("gesture_band", n, steps, [this, origin]() {
+            for(int i = 0; i < steps; i++) {
+                render->updateGesture(origin + QPoint(30 + i % 100, 30 + i % 50));
+                paint(true);
+            }
+        }));
+        render->endGesture(origin);
+
+        render->startGesture(Qt::MiddleButton, origin);
+        results.push_back(once("gesture_pan", n, steps, [this, origin]() {
+            for(int i = 0; i < steps; i++) {
+                int dx = (i / 50) % 2 ? -2 : 2;
+                render->updateGesture(origin + QPoint(30 + dx * (i % 50), 0));
+                QPainter g(&image);
+                render->paint(&g, &widget);
+            }
+        }));
+        render->endGesture(origin);
+
+        render->removeSeries(series);
+        delete series;
+    }
+};
+
+void writeJson(FILE *out, const vector<Result> &results, int width, int height) {
+    CNumericLocale c;
+    fprintf(out, "{\n  \"width\": %d,\n  \"height\": %d,\n  \"results\": [\n", width, height);
+    for(size_t i = 0; i < results.size(); i++) {
+        const Result &r = results[i];
+        fprintf(out, "    {\"name\": \"%s\", \"size\": %zu, \"iterations\": %d, \"median_ms\": %.4f, \"min_ms\": %.4f, \"per_item_ns\": %.3f, \"drawn\": %llu}%s\n",
+                r.name, r.size, r.iterations, r.median_ms, r.min_ms, r.per_item_ns,
+                (unsigned long long)r.drawn, i + 1 < results.size() ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    if(qgetenv("QT_QPA_PLATFORM").isEmpty()) qputenv("QT_QPA_PLATFORM", "offscreen");
+    QApplication a(argc, argv);
+
+    QStringList args = a.arguments();
+    size_t max_size = 100000000;
+    QString out_path;
+    int width = 1280;
+    int height = 720;
+    int max = args.indexOf("--max");
+    if(max >= 0 && max + 1 < args.size()) {
+        max_size = args[max + 1].toULongLong();
+    }
+    int out = args.indexOf("--out");
+    if(out >= 0 && out + 1 < args.size()) {
+        out_path = args[out + 1];
+    }
+    int w = args.indexOf("--width");
+    if(w >= 0 && w + 1 < args.size()) {
+        width = args[w + 1].toInt();
+    }
+    int h = args.indexOf("--height");
+    if(h >= 0 && h + 1 < args.size()) {
+        height = args[h + 1].toInt();
+    }
+
+    Bench bench(width, height);
+    for(size_t n = 1000; n <= max_size; n *= 10) {
+        fprintf(stderr, "size %zu\n", n);
+        bench.run(n);
+    }
+
+    FILE *file = stdout;
+    if(!out_path.isEmpty()) {
+        file = fopen(out_path.toLocal8Bit().constData(), "w");
+        if(!file) {
+            perror(out_path.toLocal8Bit().constData());
+            return 1;
+        }
+    }
+    writeJson(file, bench.getResults(), width, height);
+    if(file != stdout) fclose(file);
+    return 0;
+}
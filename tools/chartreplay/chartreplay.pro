@@ -0,0 +1,20 @@
+#-------------------------------------------------
+#
+# Headless load replay and soak harness for the chart view. Links the
+# chartcore library, so build it through engine.pro.
+#
+#-------------------------------------------------
+
+TEMPLATE = app
+TARGET = chartreplay
+CONFIG += console c++17
+CONFIG -= app_bundle
+
+include(../../linkcore.pri)
+
+SOURCES += \
+    main.cpp \
+    replayharness.cpp
+
+HEADERS += \
+    replayharness.h
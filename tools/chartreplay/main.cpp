@@ -0,0 +1,115 @@
+#include <QApplication>
+
+#include <cstdio>
+
+#include "recorder.h"
+#include "replayharness.h"
+
+using namespace std;
+
+// Feeds N series into a real chart view while replaying scripted gestures,
+// and reports frame rate, dropped frames, ingest-to-pixel latency and
+// memory every --interval msec:
+//
+//   chartreplay [--series 4] [--rate 1000] [--speed 1] [--duration 60000]
+//               [--replay recording.xyr] [--script gestures.txt]
+//               [--interval 1000] [--size 1280x720] [--out report.json]
+//
+// Series are generated at --rate samples per second each, or replay a
+// recording (recorder.h) paced by its x values; --speed scales both. The
+// gesture script format is described at ReplayHarness::parseScript(); the
+// default one zooms, pans and resets every 12 s. A duration of 0 runs
+// until killed. Runs on the offscreen platform unless QT_QPA_PLATFORM
+// says otherwise.
+
+int main(int argc, char *argv[])
+{
+    if(qgetenv("QT_QPA_PLATFORM").isEmpty()) qputenv("QT_QPA_PLATFORM", "offscreen");
+    QApplication a(argc, argv);
+
+    QStringList args = a.arguments();
+    int series = 4;
+    qreal rate = 1000;
+    qreal speed = 1;
+    qint64 duration = 60000;
+    int interval = 1000;
+    int width = 1280;
+    int height = 720;
+    QString out_path;
+    vector<XYItem> recording;
+    vector<ReplayAction> script = ReplayHarness::defaultScript();
+
+    int n = args.indexOf("--series");
+    if(n >= 0 && n + 1 < args.size()) {
+        series = args[n + 1].toInt();
+    }
+    int r = args.indexOf("--rate");
+    if(r >= 0 && r + 1 < args.size()) {
+        rate = args[r + 1].toDouble();
+    }
+    int s = args.indexOf("--speed");
+    if(s >= 0 && s + 1 < args.size()) {
+        speed = args[s + 1].toDouble();
+    }
+    int d = args.indexOf("--duration");
+    if(d >= 0 && d + 1 < args.size()) {
+        duration = args[d + 1].toLongLong();
+    }
+    int i = args.indexOf("--interval");
+    if(i >= 0 && i + 1 < args.size()) {
+        interval = args[i + 1].toInt();
+    }
+    int size = args.indexOf("--size");
+    if(size >= 0 && size + 1 < args.size()) {
+        QStringList wh = args[size + 1].split('x');
+        if(wh.size() == 2) {
+            width = wh[0].toInt();
+            height = wh[1].toInt();
+        }
+    }
+    int out = args.indexOf("--out");
+    if(out >= 0 && out + 1 < args.size()) {
+        out_path = args[out + 1];
+    }
+    int replay = args.indexOf("--replay");
+    if(replay >= 0 && replay + 1 < args.size()) {
+        XYSeries scratch("recording");
+        try {
+            SeriesRecorder::replay(args[replay + 1], &scratch, false);
+        } catch(int) {
+            perror(args[replay + 1].toLocal8Bit().constData());
+            return 1;
+        }
+        recording.reserve(scratch.getCount());
+        for(size_t k = 0; k < scratch.getCount(); k++) recording.push_back(scratch.getItem(k));
+        if(recording.size() < 2 || !(recording.back().x() > recording.front().x())) {
+            fprintf(stderr, "chartreplay: %s needs at least two samples at different x to replay\n", args[replay + 1].toLocal8Bit().constData());
+            return 1;
+        }
+    }
+    int sc = args.indexOf("--script");
+    if(sc >= 0 && sc + 1 < args.size()) {
+        try {
+            script = ReplayHarness::parseScript(args[sc + 1]);
+        } catch(int) {
+            fprintf(stderr, "chartreplay: can't read script %s\n", args[sc + 1].toLocal8Bit().constData());
+            return 1;
+        }
+    }
+    if(series < 1 || rate <= 0 || speed <= 0 || interval <= 0) {
+        fprintf(stderr, "chartreplay: bad arguments\n");
+        return 1;
+    }
+
+    ReplayHarness harness(series, rate, speed, recording, width, height);
+    harness.setScript(script);
+    QObject::connect(&harness, SIGNAL(finished()), &a, SLOT(quit()));
+    harness.start(duration, interval);
+    a.exec();
+
+    if(!harness.writeReport(out_path)) {
+        perror(out_path.toLocal8Bit().constData());
+        return 1;
+    }
+    return 0;
+}
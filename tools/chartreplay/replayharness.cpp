@@ -0,0 +1,362 @@
+#include "replayharness.h"
+#include "numericlocale.h"
+
+#include <QApplication>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+
+// Reports every paint to the harness, and whether it re-rendered the
+// content or only blitted the cached frame under an overlay.
+class ReplayChart : public Chart {
+private:
+    ReplayHarness *harness;
+
+public:
+    ReplayChart(ReplayHarness *_harness) : harness(_harness) {}
+
+protected:
+    void paintEvent(QPaintEvent *event) override {
+        quint64 before = getRender()->getStats().frames;
+        Chart::paintEvent(event);
+        harness->onFrame(getRender()->getStats().frames != before);
+    }
+};
+
+namespace {
+
+quint64 residentBytes() {
+    FILE *f = fopen("/proc/self/statm", "r");
+    if(!f) return 0;
+    unsigned long long size = 0;
+    unsigned long long resident = 0;
+    if(fscanf(f, "%llu %llu", &size, &resident) != 2) resident = 0;
+    fclose(f);
+    return resident * sysconf(_SC_PAGESIZE);
+}
+
+qreal percentile(vector<qreal> &values, qreal p) {
+    if(values.empty()) return 0;
+    size_t k = min(values.size() - 1, size_t(p * values.size()));
+    nth_element(values.begin(), values.begin() + k, values.end());
+    return values[k];
+}
+
+}
+
+ReplaySource::ReplaySource(XYSeries *_series, qreal _rate, int seed, const vector<XYItem> &_recording) :
+    series(_series),
+    rate(_rate),
+    recording(_recording),
+    span(0),
+    sent(0),
+    random(seed),
+    noise(0, 0.05)
+{
+    // A single sample, or samples all at one x, have no span to wrap
+    // around by.
+    if(recording.size() == 1) throw 1;
+    if(!recording.empty()) {
+        qreal width = recording.back().x() - recording.front().x();
+        if(!(width > 0) || !std::isfinite(width)) throw 1;
+        span = width + width / (recording.size() - 1);
+    }
+}
+
+size_t ReplaySource::feed(qreal seconds) {
+    batch.clear();
+    if(recording.empty()) {
+        size_t due = size_t(seconds * rate);
+        for(; sent < due; sent++) {
+            qreal x = sent / rate;
+            qreal y = sin(x * 1.3) + 0.3 * sin(x * 17) + noise(random);
+            batch.push_back(XYItem(x, y));
+        }
+    } else {
+        size_t n = recording.size();
+        qreal origin = recording.front().x();
+        while(true) {
+            const XYItem &item = recording[sent % n];
+            qreal x = item.x() + (sent / n) * span;
+            if(x - origin > seconds) break;
+            batch.push_back(XYItem(x, item.y()));
+            sent++;
+        }
+    }
+    if(!batch.empty()) series->addAll(batch);
+    return batch.size();
+}
+
+ReplayHarness::ReplayHarness(int series, qreal rate, qreal _speed, const vector<XYItem> &recording, int width, int height) :
+    next_action(0),
+    script_offset(0),
+    speed(_speed),
+    duration(0),
+    gesture_steps(0),
+    gesture_button(Qt::NoButton),
+    gesture_step(0),
+    frames(0),
+    dropped(0),
+    samples(0),
+    window_frames(0),
+    window_dropped(0),
+    window_samples(0),
+    window_start(0)
+{
+    Axis *domain = new Axis("Time", 0, 1);
+    domain->setAutoRange(true);
+    Axis *range = new Axis("Value", -2, 2);
+    range->setAutoRange(true);
+
+    render = new XYRender(false, true);
+    render->setDomainAxis(domain);
+    render->setRangeAxis(range);
+    render->setProgressive(true, false);
+    for(int i = 0; i < series; i++) {
+        XYSeries *s = new XYSeries(QString("replay %1").arg(i));
+        render->addSeries(s, QColor::fromHsv(i * 360 / series, 200, 220));
+        sources.push_back(new ReplaySource(s, rate, i + 1, recording));
+    }
+
+    chart = new ReplayChart(this);
+    chart->setRender(render);
+    chart->resize(width, height);
+
+    ingest_timer.setTimerType(Qt::PreciseTimer);
+    connect(&ingest_timer, SIGNAL(timeout()), this, SLOT(onIngestTimer()));
+    connect(&report_timer, SIGNAL(timeout()), this, SLOT(onReportTimer()));
+    end_timer.setSingleShot(true);
+    connect(&end_timer, SIGNAL(timeout()), this, SLOT(onEndTimer()));
+}
+
+ReplayHarness::~ReplayHarness()
+{
+    for(ReplaySource *source : sources) delete source;
+    delete chart;
+}
+
+void ReplayHarness::setScript(const vector<ReplayAction> &script) {
+    this->script = script;
+    stable_sort(this->script.begin(), this->script.end(), [](const ReplayAction &a, const ReplayAction &b) {
+        return a.at < b.at;
+    });
+    next_action = 0;
+    script_offset = 0;
+}
+
+void ReplayHarness::start(qint64 duration, int report_interval) {
+    this->duration = duration;
+    chart->show();
+    clock.start();
+    ingest_timer.start(4);
+    report_timer.start(report_interval);
+    if(duration > 0) end_timer.start(duration);
+}
+
+QPoint ReplayHarness::areaPoint(qreal x, qreal y) const {
+    QRectF area = render->getArea();
+    return QPointF(area.left() + x * area.width(), area.top() + y * area.height()).toPoint();
+}
+
+// Drags run over GESTURE_STEPS ingest ticks, like a mouse would, so data
+// keeps arriving while they are in progress.
+void ReplayHarness::runAction(const ReplayAction &action) {
+    switch(action.type) {
+    case ReplayAction::ZOOM:
+        render->zoomAt(areaPoint(action.x1, action.y1), action.x2);
+        break;
+    case ReplayAction::PAN:
+        gesture_button = Qt::MiddleButton;
+        gesture_from = areaPoint(0.5, 0.5);
+        gesture_to = areaPoint(0.5 + action.x1, 0.5 + action.y1);
+        break;
+    case ReplayAction::BAND:
+        gesture_button = Qt::LeftButton;
+        gesture_from = areaPoint(action.x1, action.y1);
+        gesture_to = areaPoint(action.x2, action.y2);
+        break;
+    case ReplayAction::BACK:
+        render->zoomBack();
+        break;
+    case ReplayAction::RESET:
+        render->resetAllAxisRange();
+        break;
+    case ReplayAction::REPEAT:
+        break;
+    }
+    if(action.type == ReplayAction::PAN || action.type == ReplayAction::BAND) {
+        gesture_steps = GESTURE_STEPS;
+        gesture_step = 0;
+        render->startGesture(gesture_button, gesture_from);
+    }
+}
+
+void ReplayHarness::stepGesture() {
+    gesture_step++;
+    QPointF from = gesture_from;
+    QPointF to = gesture_to;
+    QPoint point = (from + (to - from) * gesture_step / gesture_steps).toPoint();
+    if(gesture_step < gesture_steps) {
+        render->updateGesture(point);
+        return;
+    }
+    render->endGesture(point);
+    gesture_steps = 0;
+}
+
+void ReplayHarness::onIngestTimer() {
+    qint64 now = clock.elapsed();
+    size_t fed = 0;
+    for(ReplaySource *source : sources) {
+        fed += source->feed(now / 1000.0 * speed);
+    }
+    if(fed) {
+        samples += fed;
+        window_samples += fed;
+        pending.push_back(clock.nsecsElapsed());
+    }
+
+    if(gesture_steps) {
+        stepGesture();
+        return;
+    }
+    while(next_action < script.size() && script[next_action].at + script_offset <= now) {
+        const ReplayAction &action = script[next_action++];
+        if(action.type == ReplayAction::REPEAT && action.at > 0) {
+            script_offset += action.at;
+            next_action = 0;
+            break;
+        }
+        runAction(action);
+        if(gesture_steps) break;
+    }
+}
+
+// Only a complete content frame has put the pending samples on screen.
+void ReplayHarness::onFrame(bool content) {
+    frames++;
+    window_frames++;
+    if(!content || !render->isComplete() || pending.empty()) return;
+    qint64 now = clock.nsecsElapsed();
+    quint64 missed = quint64((now - pending.front()) / 1e6 / FRAME_INTERVAL);
+    dropped += missed;
+    window_dropped += missed;
+    for(qint64 t : pending) latencies.push_back((now - t) / 1e6);
+    pending.clear();
+}
+
+void ReplayHarness::onReportTimer() {
+    qint64 now = clock.elapsed();
+    qreal seconds = max<qint64>(1, now - window_start) / 1000.0;
+    ReplaySample s;
+    s.at = now / 1000.0;
+    s.frames = window_frames;
+    s.fps = window_frames / seconds;
+    s.dropped = window_dropped;
+    s.samples = window_samples;
+    s.latency_p50 = percentile(latencies, 0.5);
+    s.latency_p99 = percentile(latencies, 0.99);
+    s.latency_max = latencies.empty() ? 0 : *max_element(latencies.begin(), latencies.end());
+    s.rss = residentBytes();
+    s.series_bytes = 0;
+    for(const SeriesStats &series : render->getStats().series) s.series_bytes += series.bytes;
+    report.push_back(s);
+
+    fprintf(stderr, "%8.1fs %6.1f fps %4llu dropped %9llu samples latency p50 %6.1f p99 %6.1f max %6.1f ms rss %6.1f MiB series %6.1f MiB\n",
+            s.at, s.fps, (unsigned long long)s.dropped, (unsigned long long)s.samples,
+            s.latency_p50, s.latency_p99, s.latency_max, s.rss / 1048576.0, s.series_bytes / 1048576.0);
+
+    latencies.clear();
+    window_frames = 0;
+    window_dropped = 0;
+    window_samples = 0;
+    window_start = now;
+}
+
+void ReplayHarness::onEndTimer() {
+    onReportTimer();
+    ingest_timer.stop();
+    report_timer.stop();
+    emit finished();
+}
+
+bool ReplayHarness::writeReport(QString path) const {
+    FILE *out = path.isEmpty() ? stdout : fopen(path.toLocal8Bit().constData(), "w");
+    if(!out) return false;
+    CNumericLocale c;
+    qreal seconds = max<qint64>(1, clock.elapsed()) / 1000.0;
+    quint64 total_frames = 0;
+    for(const ReplaySample &s : report) total_frames += s.frames;
+    fprintf(out, "{\n  \"series\": %zu,\n  \"speed\": %g,\n  \"duration_ms\": %lld,\n", sources.size(), speed, (long long)duration);
+    fprintf(out, "  \"frames\": %llu,\n  \"fps\": %.2f,\n  \"dropped\": %llu,\n  \"samples\": %llu,\n",
+            (unsigned long long)frames, total_frames / seconds, (unsigned long long)dropped, (unsigned long long)samples);
+    fprintf(out, "  \"timeline\": [\n");
+    for(size_t i = 0; i < report.size(); i++) {
+        const ReplaySample &s = report[i];
+        fprintf(out, "    {\"t\": %.3f, \"fps\": %.2f, \"frames\": %llu, \"dropped\": %llu, \"samples\": %llu, "
+                     "\"latency_p50_ms\": %.3f, \"latency_p99_ms\": %.3f, \"latency_max_ms\": %.3f, \"rss\": %llu, \"series_bytes\": %llu}%s\n",
+                s.at, s.fps, (unsigned long long)s.frames, (unsigned long long)s.dropped, (unsigned long long)s.samples,
+                s.latency_p50, s.latency_p99, s.latency_max, (unsigned long long)s.rss, (unsigned long long)s.series_bytes,
+                i + 1 < report.size() ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+    if(out != stdout) fclose(out);
+    return true;
+}
+
+// One action per line, '#' starts a comment:
+//
+//   <msec> zoom <x> <y> <factor>
+//   <msec> pan <dx> <dy>
+//   <msec> band <x1> <y1> <x2> <y2>
+//   <msec> back
+//   <msec> reset
+//   <msec> repeat
+vector<ReplayAction> ReplayHarness::parseScript(QString path) {
+    FILE *f = fopen(path.toLocal8Bit().constData(), "r");
+    if(!f) throw 1;
+    vector<ReplayAction> script;
+    char line[256];
+    while(fgets(line, sizeof(line), f)) {
+        char *comment = strchr(line, '#');
+        if(comment) *comment = 0;
+        long long at;
+        char name[16];
+        double a = 0, b = 0, c = 0, d = 0;
+        int n = sscanf(line, "%lld %15s %lf %lf %lf %lf", &at, name, &a, &b, &c, &d);
+        if(n <= 0) continue;
+        ReplayAction action(at, ReplayAction::RESET, a, b, c, d);
+        if(n < 2) n = -1;
+        else if(!strcmp(name, "zoom") && n == 5) action.type = ReplayAction::ZOOM;
+        else if(!strcmp(name, "pan") && n == 4) action.type = ReplayAction::PAN;
+        else if(!strcmp(name, "band") && n == 6) action.type = ReplayAction::BAND;
+        else if(!strcmp(name, "back")) action.type = ReplayAction::BACK;
+        else if(!strcmp(name, "reset")) action.type = ReplayAction::RESET;
+        else if(!strcmp(name, "repeat")) action.type = ReplayAction::REPEAT;
+        else n = -1;
+        if(n < 0) {
+            fclose(f);
+            throw 1;
+        }
+        script.push_back(action);
+    }
+    fclose(f);
+    return script;
+}
+
+// Zoom in twice, pan, band zoom, step back out and reset, every 12 s.
+vector<ReplayAction> ReplayHarness::defaultScript() {
+    vector<ReplayAction> script;
+    script.push_back(ReplayAction(2000, ReplayAction::ZOOM, 0.5, 0.5, 0.5));
+    script.push_back(ReplayAction(3000, ReplayAction::ZOOM, 0.7, 0.5, 0.5));
+    script.push_back(ReplayAction(4000, ReplayAction::PAN, 0.2, 0));
+    script.push_back(ReplayAction(6000, ReplayAction::BAND, 0.25, 0.25, 0.75, 0.75));
+    script.push_back(ReplayAction(8000, ReplayAction::BACK));
+    script.push_back(ReplayAction(9000, ReplayAction::BACK));
+    script.push_back(ReplayAction(10000, ReplayAction::RESET));
+    script.push_back(ReplayAction(12000, ReplayAction::REPEAT));
+    return script;
+}
@@ -0,0 +1,143 @@
+#ifndef REPLAYHARNESS_H
+#define REPLAYHARNESS_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QTimer>
+
+#include <random>
+#include <vector>
+
+#include "chart.h"
+
+using namespace std;
+
+// One scripted step, at msec from the start of the run (or of the repeat
+// period). Positions are fractions of the plot area.
+class ReplayAction {
+public:
+    enum Type { ZOOM, PAN, BAND, BACK, RESET, REPEAT };
+
+    qint64 at;
+    Type type;
+    qreal x1;
+    qreal y1;
+    qreal x2;
+    qreal y2;
+
+public:
+    ReplayAction(qint64 _at = 0, Type _type = RESET, qreal _x1 = 0, qreal _y1 = 0, qreal _x2 = 0, qreal _y2 = 0) :
+        at(_at), type(_type), x1(_x1), y1(_y1), x2(_x2), y2(_y2) {}
+};
+
+// Feeds one series, either generated at a fixed rate or from a recording
+// (recorder.h) paced by its x values taken as seconds. Recordings wrap
+// around, shifted past their end, so a soak can outlast them; one needs at
+// least two samples spanning some x.
+class ReplaySource {
+private:
+    XYSeries *series;
+    qreal rate;
+    vector<XYItem> recording;
+    qreal span;
+    size_t sent;
+    mt19937_64 random;
+    normal_distribution<qreal> noise;
+    vector<XYItem> batch;
+
+public:
+    ReplaySource(XYSeries *_series, qreal _rate, int seed, const vector<XYItem> &_recording);
+    // Appends everything due by seconds of replay time; returns the count.
+    size_t feed(qreal seconds);
+    XYSeries* getSeries() const {
+        return series;
+    }
+};
+
+class ReplaySample {
+public:
+    qreal at;
+    qreal fps;
+    quint64 frames;
+    quint64 dropped;
+    quint64 samples;
+    qreal latency_p50;
+    qreal latency_p99;
+    qreal latency_max;
+    quint64 rss;
+    quint64 series_bytes;
+};
+
+class ReplayChart;
+
+// Drives a real Chart: ingest on a fast timer, scripted gestures, and a
+// report every interval with frame rate, dropped frames, ingest-to-pixel
+// latency and memory. A frame counts as dropped for every frame interval
+// that appended data waited past its first one.
+class ReplayHarness : public QObject
+{
+    Q_OBJECT
+
+public:
+    constexpr static qreal FRAME_INTERVAL = 1000.0 / 60;
+    constexpr static int GESTURE_STEPS = 10;
+
+private:
+    ReplayChart *chart;
+    XYRender *render;
+    vector<ReplaySource*> sources;
+    vector<ReplayAction> script;
+    size_t next_action;
+    qint64 script_offset;
+    qreal speed;
+    qint64 duration;
+
+    QElapsedTimer clock;
+    QTimer ingest_timer;
+    QTimer report_timer;
+    QTimer end_timer;
+
+    int gesture_steps;
+    int gesture_button;
+    QPoint gesture_from;
+    QPoint gesture_to;
+    int gesture_step;
+
+    vector<qint64> pending;
+    vector<qreal> latencies;
+    quint64 frames;
+    quint64 dropped;
+    quint64 samples;
+    quint64 window_frames;
+    quint64 window_dropped;
+    quint64 window_samples;
+    qint64 window_start;
+    vector<ReplaySample> report;
+
+    QPoint areaPoint(qreal x, qreal y) const;
+    void runAction(const ReplayAction &action);
+    void stepGesture();
+
+public:
+    ReplayHarness(int series, qreal rate, qreal _speed, const vector<XYItem> &recording, int width, int height);
+    ~ReplayHarness();
+
+    void setScript(const vector<ReplayAction> &script);
+    void start(qint64 duration, int report_interval);
+    // Called by the chart after each paint.
+    void onFrame(bool content);
+    bool writeReport(QString path) const;
+
+    static vector<ReplayAction> parseScript(QString path);
+    static vector<ReplayAction> defaultScript();
+
+signals:
+    void finished();
+
+private slots:
+    void onIngestTimer();
+    void onReportTimer();
+    void onEndTimer();
+};
+
+#endif // REPLAYHARNESS_H
@@ -0,0 +1,45 @@
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+#include "seriesfile.h"
+
+using namespace std;
+
+// Writes a noisy multi-tone trace of the given length into a series file:
+//
+//   seriesgen <file> <samples>
+//
+// e.g. `seriesgen trace.xys 3000000000` for a ~48 GB file, then open it
+// with `chart --open trace.xys`.
+
+int main(int argc, char *argv[])
+{
+    if(argc < 3) {
+        fprintf(stderr, "usage: %s <file> <samples>\n", argv[0]);
+        return 1;
+    }
+    uint64_t count = strtoull(argv[2], nullptr, 10);
+
+    try {
+        SeriesFileWriter writer(argv[1], count);
+        mt19937_64 random(1);
+        normal_distribution<double> noise(0, 0.05);
+        for(uint64_t i = 0; i < count; i++) {
+            double x = i * 1e-3;
+            double y = sin(x * 0.01) + 0.3 * sin(x * 1.7) + noise(random);
+            if(i % 10000000 == 9999999) y += 3;
+            writer.write(x, y);
+            if(i % 100000000 == 0) {
+                fprintf(stderr, "\r%.1f%%", 100.0 * i / count);
+            }
+        }
+        writer.finish();
+        fprintf(stderr, "\rdone  \n");
+    } catch(int) {
+        perror(argv[1]);
+        return 1;
+    }
+    return 0;
+}
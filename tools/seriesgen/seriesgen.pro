@@ -0,0 +1,18 @@
+#-------------------------------------------------
+#
+# Writes synthetic series files (seriesfile.h) for MappedStorage.
+#
+#-------------------------------------------------
+
+TEMPLATE = app
+TARGET = seriesgen
+CONFIG += console c++11
+CONFIG -= qt app_bundle
+
+INCLUDEPATH += ../..
+
+SOURCES += \
+    main.cpp
+
+HEADERS += \
+    ../../seriesfile.h
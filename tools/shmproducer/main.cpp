@@ -0,0 +1,102 @@
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#include "shmring.h"
+
+using namespace std;
+
+// Writes a sine wave into a shared-memory ring for testing ShmStorage on
+// localhost:
+//
+//   shmproducer [name] [capacity] [samples per second]
+//
+// and start the viewer with `chart --shm <name>`. The ring is unlinked on
+// SIGINT/SIGTERM.
+
+static volatile sig_atomic_t running = 1;
+
+static void stop(int) {
+    running = 0;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *name = argc > 1 ? argv[1] : "/chart";
+    uint64_t capacity = argc > 2 ? strtoull(argv[2], nullptr, 10) : 1 << 20;
+    double rate = argc > 3 ? atof(argv[3]) : 10000;
+    if(capacity == 0 || rate <= 0) {
+        fprintf(stderr, "usage: %s [name] [capacity] [samples per second]\n", argv[0]);
+        return 1;
+    }
+
+    size_t length = shm_ring_size(capacity);
+    int fd = shm_open(name, O_CREAT | O_RDWR, 0644);
+    if(fd < 0) {
+        perror("shm_open");
+        return 1;
+    }
+    if(ftruncate(fd, length) < 0) {
+        perror("ftruncate");
+        return 1;
+    }
+    void *base = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if(base == MAP_FAILED) {
+        perror("mmap");
+        return 1;
+    }
+
+    ShmRingHeader *header = static_cast<ShmRingHeader*>(base);
+    bool reuse = header->magic == SHM_RING_MAGIC
+            && header->version == SHM_RING_VERSION
+            && header->capacity == capacity;
+    if(!reuse) {
+        memset(base, 0, sizeof(ShmRingHeader));
+        header->capacity = capacity;
+        header->x_offset = sizeof(ShmRingHeader);
+        header->y_offset = sizeof(ShmRingHeader) + capacity * sizeof(double);
+        header->version = SHM_RING_VERSION;
+        header->magic = SHM_RING_MAGIC;
+    }
+    header->write_seq.store(0, memory_order_release);
+    header->generation.fetch_add(1, memory_order_release);
+
+    double *xs = reinterpret_cast<double*>(static_cast<char*>(base) + header->x_offset);
+    double *ys = reinterpret_cast<double*>(static_cast<char*>(base) + header->y_offset);
+
+    signal(SIGINT, stop);
+    signal(SIGTERM, stop);
+
+    printf("writing %g samples/s into %s (capacity %llu)\n", rate, name, (unsigned long long)capacity);
+
+    auto start = chrono::steady_clock::now();
+    uint64_t seq = 0;
+    while(running) {
+        this_thread::sleep_for(chrono::milliseconds(1));
+        double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        uint64_t target = (uint64_t)(elapsed * rate);
+        header->claim_seq.store(target, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+        for(; seq < target; seq++) {
+            double x = seq / rate;
+            size_t slot = seq % capacity;
+            xs[slot] = x;
+            ys[slot] = sin(x * 2 * M_PI) + 1;
+        }
+        header->write_seq.store(seq, memory_order_release);
+    }
+
+    munmap(base, length);
+    shm_unlink(name);
+    return 0;
+}
@@ -0,0 +1,20 @@
+#-------------------------------------------------
+#
+# Reference producer for the shared-memory sample ring (shmring.h).
+#
+#-------------------------------------------------
+
+TEMPLATE = app
+TARGET = shmproducer
+CONFIG += console c++11
+CONFIG -= qt app_bundle
+
+INCLUDEPATH += ../..
+
+SOURCES += \
+    main.cpp
+
+HEADERS += \
+    ../../shmring.h
+
+unix: LIBS += -lrt
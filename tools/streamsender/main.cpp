@@ -0,0 +1,192 @@
+#include <QCoreApplication>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QUdpSocket>
+#include <QHostAddress>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QFile>
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "streamframe.h"
+
+using namespace std;
+
+// Drives a StreamSource on localhost:
+//
+//   streamsender --local <name> | --udp <port>
+//                [--rate <samples/s>] [--frame <samples>] [--replay <file>]
+//
+// Without --replay a sine wave is generated; with it the frames stored back
+// to back in <file> (wire format of streamframe.h) are re-sent in a loop,
+// renumbered and with x shifted so the stream stays increasing.
+// For --local the sender is the server: start it first, then the viewer
+// with `chart --local <name>`.
+
+class Generator {
+public:
+    virtual ~Generator() {}
+    virtual void next(double *xs, double *ys, uint32_t count) = 0;
+};
+
+class SineGenerator : public Generator {
+private:
+    double rate;
+    uint64_t n;
+
+public:
+    SineGenerator(double _rate) : rate(_rate), n(0) {}
+    void next(double *xs, double *ys, uint32_t count) {
+        for(uint32_t i = 0; i < count; i++, n++) {
+            xs[i] = n / rate;
+            ys[i] = sin(xs[i] * 2 * M_PI) + 1;
+        }
+    }
+};
+
+class ReplayGenerator : public Generator {
+private:
+    vector<double> xs;
+    vector<double> ys;
+    size_t pos;
+    double offset;
+
+public:
+    ReplayGenerator(const QByteArray &data) : pos(0), offset(0) {
+        size_t used = 0;
+        size_t size = data.size();
+        while(size - used >= sizeof(StreamFrameHeader)) {
+            StreamFrameHeader header;
+            memcpy(&header, data.constData() + used, sizeof(header));
+            if(header.magic != STREAM_FRAME_MAGIC || size - used < stream_frame_size(header.count)) break;
+            const char *x = data.constData() + used + sizeof(header);
+            const char *y = x + header.count * sizeof(double);
+            size_t at = xs.size();
+            xs.resize(at + header.count);
+            ys.resize(at + header.count);
+            memcpy(&xs[at], x, header.count * sizeof(double));
+            memcpy(&ys[at], y, header.count * sizeof(double));
+            used += stream_frame_size(header.count);
+        }
+    }
+    bool empty() const {
+        return xs.size() < 2;
+    }
+    void next(double *x, double *y, uint32_t count) {
+        for(uint32_t i = 0; i < count; i++) {
+            if(pos == xs.size()) {
+                offset += xs.back() - xs.front() + (xs[1] - xs[0]);
+                pos = 0;
+            }
+            x[i] = xs[pos] + offset;
+            y[i] = ys[pos];
+            pos++;
+        }
+    }
+};
+
+static void usage(const char *self) {
+    fprintf(stderr, "usage: %s --local <name> | --udp <port> [--rate <samples/s>] [--frame <samples>] [--replay <file>]\n", self);
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QStringList args = app.arguments();
+
+    QString local;
+    int port = -1;
+    double rate = 1000000;
+    uint32_t frame = 2048;
+    QString replay;
+    for(int i = 1; i + 1 < args.size(); i += 2) {
+        if(args[i] == "--local") local = args[i+1];
+        else if(args[i] == "--udp") port = args[i+1].toInt();
+        else if(args[i] == "--rate") rate = args[i+1].toDouble();
+        else if(args[i] == "--frame") frame = args[i+1].toUInt();
+        else if(args[i] == "--replay") replay = args[i+1];
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if((local.isEmpty() == (port < 0)) || rate <= 0 || frame == 0 || frame > STREAM_FRAME_MAX) {
+        usage(argv[0]);
+        return 1;
+    }
+    if(port >= 0 && frame > STREAM_FRAME_MAX_UDP) {
+        frame = STREAM_FRAME_MAX_UDP;
+    }
+
+    Generator *generator;
+    if(replay.isEmpty()) {
+        generator = new SineGenerator(rate);
+    } else {
+        QFile file(replay);
+        if(!file.open(QIODevice::ReadOnly)) {
+            fprintf(stderr, "cannot open %s\n", qPrintable(replay));
+            return 1;
+        }
+        ReplayGenerator *r = new ReplayGenerator(file.readAll());
+        if(r->empty()) {
+            fprintf(stderr, "no frames in %s\n", qPrintable(replay));
+            return 1;
+        }
+        generator = r;
+    }
+
+    QLocalServer server;
+    QLocalSocket *stream = nullptr;
+    QUdpSocket udp;
+    if(!local.isEmpty()) {
+        QLocalServer::removeServer(local);
+        if(!server.listen(local)) {
+            fprintf(stderr, "listen: %s\n", qPrintable(server.errorString()));
+            return 1;
+        }
+        printf("waiting for viewer on %s\n", qPrintable(local));
+        fflush(stdout);
+        server.waitForNewConnection(-1);
+        stream = server.nextPendingConnection();
+        if(!stream) return 1;
+    }
+
+    vector<double> xs(frame);
+    vector<double> ys(frame);
+    vector<char> buffer(stream_frame_size(frame));
+
+    QElapsedTimer clock;
+    clock.start();
+    uint64_t seq = 0;
+    uint64_t sent = 0;
+    uint64_t reported = 0;
+    qint64 last_report = 0;
+    for(;;) {
+        qint64 due = (qint64)(sent * 1000 / rate);
+        qint64 now = clock.elapsed();
+        if(due > now) QThread::msleep(due - now);
+
+        generator->next(xs.data(), ys.data(), frame);
+        stream_frame_pack(buffer.data(), seq++, xs.data(), ys.data(), frame);
+        if(stream) {
+            if(stream->write(buffer.data(), buffer.size()) < 0) break;
+            if(!stream->waitForBytesWritten(1000)) break;
+        } else {
+            udp.writeDatagram(buffer.data(), buffer.size(), QHostAddress::LocalHost, port);
+        }
+        sent += frame;
+
+        now = clock.elapsed();
+        if(now - last_report >= 1000) {
+            printf("%.0f samples/s\n", (sent - reported) * 1000.0 / (now - last_report));
+            fflush(stdout);
+            reported = sent;
+            last_report = now;
+        }
+    }
+    delete generator;
+    return 0;
+}
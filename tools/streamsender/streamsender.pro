@@ -0,0 +1,21 @@
+#-------------------------------------------------
+#
+# Local replay sender for StreamSource (streamframe.h).
+#
+#-------------------------------------------------
+
+QT       += core network
+QT       -= gui
+
+TEMPLATE = app
+TARGET = streamsender
+CONFIG += console c++11
+CONFIG -= app_bundle
+
+INCLUDEPATH += ../..
+
+SOURCES += \
+    main.cpp
+
+HEADERS += \
+    ../../streamframe.h
@@ -0,0 +1,132 @@
+#include "vectorexport.h"
+
+#include <QBuffer>
+#include <QPageSize>
+#include <QPdfWriter>
+#include <QSvgGenerator>
+
+void PainterSeriesSink::beginSeries(XYSeries *, QColor color, QRectF clip) {
+    this->color = color;
+    g->save();
+    g->setClipRect(clip);
+    g->setRenderHint(QPainter::Antialiasing, true);
+}
+
+void PainterSeriesSink::addLine(const QPointF *points, int count) {
+    QPen pen;
+    pen.setColor(color);
+    pen.setWidthF(XYRender::LINE_WIDTH);
+    g->setPen(pen);
+    g->setBrush(Qt::NoBrush);
+    g->drawPolyline(points, count);
+}
+
+void PainterSeriesSink::addMarks(const QPointF *points, int count) {
+    g->setPen(Qt::NoPen);
+    g->setBrush(color);
+    for(int i = 0; i < count; i++) {
+        g->drawEllipse(points[i], XYRender::MARK_RADIUS, XYRender::MARK_RADIUS);
+    }
+}
+
+void PainterSeriesSink::addImage(QRectF rect, const QImage &image) {
+    g->drawImage(rect, image);
+}
+
+void PainterSeriesSink::endSeries() {
+    g->restore();
+}
+
+void SvgSeriesWriter::beginSeries(XYSeries *, QColor color, QRectF clip) {
+    if(!clipped) {
+        fprintf(out, "<defs><clipPath id=\"series-clip\"><rect x=\"%.2f\" y=\"%.2f\" width=\"%.2f\" height=\"%.2f\"/></clipPath></defs>\n",
+                clip.x(), clip.y(), clip.width(), clip.height());
+        clipped = true;
+    }
+    this->color = color.name();
+    fprintf(out, "<g clip-path=\"url(#series-clip)\" opacity=\"%.3f\">\n", color.alpha() / 255.0);
+}
+
+void SvgSeriesWriter::addLine(const QPointF *points, int count) {
+    fprintf(out, "<polyline fill=\"none\" stroke=\"%s\" stroke-width=\"%g\" stroke-linejoin=\"round\" points=\"",
+            color.toLatin1().constData(), XYRender::LINE_WIDTH);
+    for(int i = 0; i < count; i++) {
+        fprintf(out, i ? " %.2f,%.2f" : "%.2f,%.2f", points[i].x(), points[i].y());
+    }
+    fprintf(out, "\"/>\n");
+}
+
+// One path of two arcs per marker is far smaller than an element each.
+void SvgSeriesWriter::addMarks(const QPointF *points, int count) {
+    qreal r = XYRender::MARK_RADIUS;
+    fprintf(out, "<path fill=\"%s\" d=\"", color.toLatin1().constData());
+    for(int i = 0; i < count; i++) {
+        fprintf(out, "M%.2f %.2fa%g %g 0 1 0 %g 0a%g %g 0 1 0 %g 0",
+                points[i].x() - r, points[i].y(), r, r, 2 * r, r, r, -2 * r);
+    }
+    fprintf(out, "\"/>\n");
+}
+
+// Embedded as a PNG data URI.
+void SvgSeriesWriter::addImage(QRectF rect, const QImage &image) {
+    QBuffer png;
+    png.open(QIODevice::WriteOnly);
+    image.save(&png, "PNG");
+    fprintf(out, "<image x=\"%.2f\" y=\"%.2f\" width=\"%.2f\" height=\"%.2f\" preserveAspectRatio=\"none\" xlink:href=\"data:image/png;base64,",
+            rect.x(), rect.y(), rect.width(), rect.height());
+    QByteArray data = png.data().toBase64();
+    fwrite(data.constData(), 1, data.size(), out);
+    fprintf(out, "\"/>\n");
+}
+
+void SvgSeriesWriter::endSeries() {
+    fprintf(out, "</g>\n");
+}
+
+bool VectorExport::writeSvg(XYRender *render, QString path, QSize size) {
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    QSvgGenerator generator;
+    generator.setOutputDevice(&buffer);
+    generator.setSize(size);
+    generator.setViewBox(QRect(QPoint(0, 0), size));
+    {
+        QPainter g(&generator);
+        render->paintChrome(&g, size);
+    }
+
+    // Keep what is inside the generator's <svg> element.
+    QByteArray chrome = buffer.data();
+    int open = chrome.indexOf("<svg");
+    int body = open < 0 ? -1 : chrome.indexOf('>', open) + 1;
+    int close = chrome.lastIndexOf("</svg>");
+    if(body <= 0 || close < body) return false;
+
+    FILE *out = fopen(path.toLocal8Bit().constData(), "w");
+    if(!out) return false;
+    fprintf(out, "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"no\"?>\n"
+                 "<svg xmlns=\"http://www.w3.org/2000/svg\" xmlns:xlink=\"http://www.w3.org/1999/xlink\" "
+                 "width=\"%d\" height=\"%d\" viewBox=\"0 0 %d %d\">\n",
+            size.width(), size.height(), size.width(), size.height());
+    fwrite(chrome.constData() + body, 1, close - body, out);
+    SvgSeriesWriter writer(out);
+    render->exportSeries(&writer);
+    fprintf(out, "</svg>\n");
+    bool ok = !ferror(out);
+    return fclose(out) == 0 && ok;
+}
+
+// The page is size pixels at dpi, so the series are reduced to the
+// device pixels of the PDF's resolution.
+bool VectorExport::writePdf(XYRender *render, QString path, QSize size, int dpi) {
+    QPdfWriter writer(path);
+    writer.setResolution(dpi);
+    writer.setPageSize(QPageSize(QSizeF(size) * 72.0 / dpi, QPageSize::Point, QString(), QPageSize::ExactMatch));
+    writer.setPageMargins(QMarginsF(0, 0, 0, 0));
+    QPainter g;
+    if(!g.begin(&writer)) return false;
+    render->paintChrome(&g, size);
+    PainterSeriesSink sink(&g);
+    render->exportSeries(&sink);
+    return g.end();
+}
@@ -0,0 +1,58 @@
+#ifndef VECTOREXPORT_H
+#define VECTOREXPORT_H
+
+#include <cstdio>
+
+#include "render.h"
+#include "numericlocale.h"
+
+// Draws the chunks of XYRender::exportSeries() onto a painter, e.g. one on
+// a QPdfWriter.
+class PainterSeriesSink : public SeriesSink {
+private:
+    QPainter *g;
+    QColor color;
+
+public:
+    PainterSeriesSink(QPainter *_g) : g(_g) {}
+    void beginSeries(XYSeries *series, QColor color, QRectF clip) override;
+    void addLine(const QPointF *points, int count) override;
+    void addMarks(const QPointF *points, int count) override;
+    void addImage(QRectF rect, const QImage &image) override;
+    void endSeries() override;
+};
+
+// Writes the chunks as SVG elements straight to a file. Numbers are
+// printed in the C locale for as long as the writer lives.
+class SvgSeriesWriter : public SeriesSink {
+private:
+    FILE *out;
+    QString color;
+    bool clipped;
+    CNumericLocale locale;
+
+public:
+    SvgSeriesWriter(FILE *_out) : out(_out), clipped(false) {}
+    void beginSeries(XYSeries *series, QColor color, QRectF clip) override;
+    void addLine(const QPointF *points, int count) override;
+    void addMarks(const QPointF *points, int count) override;
+    void addImage(QRectF rect, const QImage &image) override;
+    void endSeries() override;
+};
+
+// Vector export of a chart at size, with the series reduced to that size
+// (see XYRender::paintChrome()), so the file follows the picture rather
+// than the sample count.
+//
+// For SVG, the axes, title and background go through QSvgGenerator, which
+// keeps its document in memory until it ends; that part is small. The
+// series are then written to the file chunk by chunk as they are walked.
+// QPdfWriter keeps each page's content in memory, so a PDF holds the
+// reduced series until it is finished.
+class VectorExport {
+public:
+    static bool writeSvg(XYRender *render, QString path, QSize size);
+    static bool writePdf(XYRender *render, QString path, QSize size, int dpi = 96);
+};
+
+#endif // VECTOREXPORT_H